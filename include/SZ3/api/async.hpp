@@ -0,0 +1,207 @@
+#ifndef SZ3_ASYNC_HPP
+#define SZ3_ASYNC_HPP
+
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+
+#include "SZ3/api/stream.hpp"
+#include "SZ3/executor/Executor_threadpool.hpp"
+
+namespace SZ3 {
+/**
+ * executor of the asynchronous API if the caller provides none: one worker per hardware thread
+ */
+inline concepts::ExecutorInterface &SZ_async_executor() {
+    static Executor_threadpool pool;
+    return pool;
+}
+
+/**
+ * rows per segment for asynchronous compression: enough segments to keep the executor busy, but not smaller than
+ * the minimum chunk size of multi-chunk compression
+ */
+inline size_t SZ_async_segment_rows(const Config &conf, int concurrency) {
+    size_t rowSize = conf.num / conf.dims[0];
+    size_t segSize = conf.num / (static_cast<size_t>(concurrency) * SZ_OMP_CHUNKS_PER_THREAD);
+    segSize = std::min<size_t>(std::max<size_t>(segSize, SZ_OMP_MIN_CHUNK_SIZE), static_cast<size_t>(1) << 24);
+    return std::max<size_t>(1, segSize / rowSize);
+}
+
+/**
+ * run task on executor and return its result through a future
+ */
+template <class R, class Task>
+std::future<R> SZ_async_run(concepts::ExecutorInterface &executor, Task task) {
+    auto promise = std::make_shared<std::promise<R>>();
+    auto future = promise->get_future();
+    executor.submit([promise, task]() mutable {
+        try {
+            promise->set_value(task());
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return future;
+}
+}  // namespace SZ3
+
+/**
+ * API for asynchronous compression
+ * The data is compressed in the background as a stream (see SZ3::StreamCompressor) of independent segments along
+ * dims[0]. Segments are compressed in parallel on the executor and handed to the sink in order as soon as they are
+ * ready, so writing overlaps with compression. At most maxInFlight segments are compressed ahead of the sink: a slow
+ * sink stalls compression instead of letting compressed data pile up in memory.
+ *
+ * @tparam T source data type
+ * @param config compression configuration. Relative error bounds, ratio targets and time budgets are resolved on the
+ * whole array.
+ * @param data source data, must stay valid and unchanged until the future is ready
+ * @param sink receives the compressed stream in order, called from one thread at a time
+ * @param executor executor to run on, a shared thread pool if nullptr
+ * @param maxInFlight maximum number of segments compressed but not yet written, 0 for twice the executor concurrency
+ * @return future for the number of bytes written to the sink; exceptions of the compressor or the sink are rethrown by
+ * its get()
+
+ example:
+ auto done = SZ_compress_async(conf, field, [&](const char *bytes, size_t len) { fwrite(bytes, 1, len, f); });
+ simulate_next_step(); // must not modify field
+ size_t cmpSize = done.get();
+ */
+template <class T>
+std::future<size_t> SZ_compress_async(const SZ3::Config &config, const T *data,
+                                      typename SZ3::StreamCompressor<T>::Sink sink,
+                                      SZ3::concepts::ExecutorInterface *executor = nullptr, size_t maxInFlight = 0) {
+    using namespace SZ3;
+    auto &ex = executor ? *executor : SZ_async_executor();
+    return SZ_async_run<size_t>(ex, [config, data, sink, &ex, maxInFlight]() {
+        Config conf(config);
+        {
+            BindScope<concepts::ExecutorInterface> executorScope(ex);
+            SZ_resolve_error_bound(conf, data);
+            SZ_resolve_time_budget(conf, data, ex.concurrency());
+        }
+        // segments are the unit of parallelism
+        conf.openmp = false;
+
+        size_t written = 0;
+        StreamCompressor<T> stream([&](const char *bytes, size_t len) {
+            sink(bytes, len);
+            written += len;
+        });
+        stream.begin(conf, SZ_async_segment_rows(conf, ex.concurrency()));
+        size_t segRows = stream.segment_rows();
+        size_t rowSize = conf.num / conf.dims[0];
+        size_t nSegments = (conf.dims[0] + segRows - 1) / segRows;
+        size_t window = maxInFlight ? maxInFlight : 2 * ex.concurrency();
+
+        struct Segment {
+            std::unique_ptr<char[]> data;
+            size_t size = 0;
+            bool ready = false;
+        };
+        std::vector<Segment> segments(nSegments);
+        std::mutex mutex;
+        std::condition_variable progress;
+        size_t nextWrite = 0;
+        bool writing = false, failed = false;
+
+        ex.parallel_for(nSegments, [&](size_t i) {
+            try {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    progress.wait(lock, [&] { return failed || i < nextWrite + window; });
+                    if (failed) {
+                        return;
+                    }
+                }
+                size_t rows = std::min(segRows, conf.dims[0] - i * segRows);
+                Config segConf = stream.segment_config(rows);
+                size_t cmpCap = SZ_compress_bound<T>(segConf);
+                std::unique_ptr<char[]> cmpData(new char[cmpCap]);
+                size_t cmpSize = SZ_compress(segConf, data + i * segRows * rowSize, cmpData.get(), cmpCap);
+                if (cmpSize == 0) {
+                    throw std::runtime_error("compression of a segment failed");
+                }
+
+                std::unique_lock<std::mutex> lock(mutex);
+                segments[i].data = std::move(cmpData);
+                segments[i].size = cmpSize;
+                segments[i].ready = true;
+                if (writing) {
+                    // the thread writing now will also write this segment when its turn comes
+                    return;
+                }
+                writing = true;
+                while (nextWrite < nSegments && segments[nextWrite].ready) {
+                    auto &segment = segments[nextWrite];
+                    lock.unlock();
+                    stream.push_compressed(std::min(segRows, conf.dims[0] - nextWrite * segRows), segment.data.get(),
+                                           segment.size);
+                    segment.data.reset();
+                    lock.lock();
+                    nextWrite++;
+                    progress.notify_all();
+                }
+                writing = false;
+            } catch (...) {
+                // release the threads waiting for a segment that will never be written
+                std::lock_guard<std::mutex> lock(mutex);
+                failed = true;
+                progress.notify_all();
+                throw;
+            }
+        });
+        stream.finish();
+        return written;
+    });
+}
+
+/**
+ * API for asynchronous decompression of a stream produced by SZ_compress_async or SZ3::StreamCompressor
+ * Segments are read from the source in order and decompressed in parallel on the executor; only the segments being
+ * decompressed are kept in memory.
+ *
+ * @tparam T decompressed data type
+ * @param source reads the compressed stream, called from one thread at a time
+ * @param decData buffer for the whole array, must stay valid until the future is ready
+ * @param executor executor to run on, a shared thread pool if nullptr
+ * @return future for the configuration of the whole array
+ */
+template <class T>
+std::future<SZ3::Config> SZ_decompress_async(typename SZ3::StreamDecompressor<T>::Source source, T *decData,
+                                             SZ3::concepts::ExecutorInterface *executor = nullptr) {
+    using namespace SZ3;
+    auto &ex = executor ? *executor : SZ_async_executor();
+    return SZ_async_run<Config>(ex, [source, decData, &ex]() {
+        StreamDecompressor<T> stream(source);
+        Config conf = stream.begin();
+        size_t segRows = stream.segment_rows();
+        size_t rowSize = conf.num / conf.dims[0];
+        size_t nSegments = (conf.dims[0] + segRows - 1) / segRows;
+
+        std::vector<std::vector<char>> segments(nSegments);
+        size_t nextRead = 0;
+        std::mutex mutex;
+        ex.parallel_for(nSegments, [&](size_t i) {
+            std::vector<char> cmpData;
+            {
+                // the stream is sequential, read up to this segment
+                std::lock_guard<std::mutex> lock(mutex);
+                for (; nextRead <= i; nextRead++) {
+                    if (!stream.next_compressed(segments[nextRead])) {
+                        throw std::invalid_argument("truncated SZ3 stream");
+                    }
+                }
+                cmpData = std::move(segments[i]);
+            }
+            Config segConf;
+            T *segData = decData + i * segRows * rowSize;
+            SZ_decompress(segConf, cmpData.data(), cmpData.size(), segData);
+        });
+        return conf;
+    });
+}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef SZ3_BATCH_HPP
+#define SZ3_BATCH_HPP
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+
+#include "SZ3/api/context.hpp"
+#include "SZ3/api/sz.hpp"
+#include "SZ3/executor/Executor_omp.hpp"
+#include "SZ3/utils/TuningCache.hpp"
+
+namespace SZ3 {
+/**
+ * one field of a batch
+ */
+template <class T>
+struct FieldDesc {
+    Config conf;
+    const T *data;
+};
+
+/**
+ * Contexts (scratch buffers, zstd contexts, output buffer) shared by the tasks of a batch.
+ * A task takes one for the duration of a field and gives it back, so there are at most as many as concurrent tasks.
+ */
+template <class T>
+class ContextPool {
+   public:
+    struct Slot {
+        Context<T> context;
+        std::vector<char> output;
+    };
+
+    std::unique_ptr<Slot> acquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (free.empty()) {
+            return std::unique_ptr<Slot>(new Slot());
+        }
+        auto slot = std::move(free.back());
+        free.pop_back();
+        return slot;
+    }
+
+    void release(std::unique_ptr<Slot> slot) {
+        std::lock_guard<std::mutex> lock(mutex);
+        free.push_back(std::move(slot));
+    }
+
+   private:
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Slot>> free;
+};
+}  // namespace SZ3
+
+/**
+ * API for compressing many fields at once (e.g., all variables of a timestep)
+ * Fields are compressed in parallel on the executor, largest first, so many medium-size fields keep all threads busy.
+ * The tasks share scratch buffers and zstd contexts instead of allocating them for each field.
+ * A TuningCache bound to the calling thread is used by all tasks; fields without a fieldId are identified by their
+ * index in fields, so that the cache carries over to the next batch of the same fields. So is a ZstdDictionary bound to
+ * the calling thread.
+ *
+ * @tparam T source data type
+ * @param fields configuration and data of each field; the output of each field is the same as SZ_compress
+ * @param sink receives the compressed data of each field with its index in fields, in completion order. It is called
+ * from one thread at a time and the buffer is only valid during the call.
+ * @param executor executor to run on; if nullptr, the executor bound to the current thread or OpenMP
+ * @param shareTuning if true, fields with ALGO_INTERP_LORENZO (and without openmp) and the same shape reuse the settings
+ * tuned on the first of them instead of sampling and tuning again. Faster, but the settings may fit the other fields
+ * less well.
+ * @return total compressed size (in bytes)
+
+ example:
+ std::vector<SZ3::FieldDesc<float>> fields = {{conf, u}, {conf, v}, {conf, w}, {conf, p}};
+ SZ_compress_batch(fields, [&](size_t i, const char *cmpData, size_t cmpSize) { write_field(i, cmpData, cmpSize); });
+ */
+template <class T>
+size_t SZ_compress_batch(const std::vector<SZ3::FieldDesc<T>> &fields,
+                         std::function<void(size_t index, const char *cmpData, size_t cmpSize)> sink,
+                         SZ3::concepts::ExecutorInterface *executor = nullptr, bool shareTuning = false) {
+    using namespace SZ3;
+    BindScope<concepts::ExecutorInterface> executorScope(executor);
+    Executor_omp fallback;
+    auto &ex = SZ_executor(fallback);
+
+    ContextPool<T> pool;
+    std::mutex sinkMutex;
+    size_t total = 0;
+    auto cache = TuningCache::current();
+    auto dictionary = ZstdDictionary::current();
+    auto compress_field = [&](size_t i, Config conf) {
+        BindScope<TuningCache> tuningScope(cache);
+        BindScope<ZstdDictionary> dictionaryScope(dictionary);
+        if (conf.fieldId < 0) {
+            conf.fieldId = static_cast<int>(i);
+        }
+        auto slot = pool.acquire();
+        slot->output.resize(SZ_compress_bound<T>(conf));
+        size_t cmpSize = slot->context.compress(conf, fields[i].data, slot->output.data(), slot->output.size());
+        if (cmpSize == 0) {
+            throw std::runtime_error("compression of a field failed");
+        }
+        {
+            std::lock_guard<std::mutex> lock(sinkMutex);
+            sink(i, slot->output.data(), cmpSize);
+            total += cmpSize;
+        }
+        if (shareTuning && conf.cmprAlgo == ALGO_INTERP_LORENZO && !conf.openmp) {
+            // the first of a group hands its tuned settings to the others
+            Config tuned;
+            auto tunedPos = reinterpret_cast<const uchar *>(slot->output.data());
+            tuned.load(tunedPos);
+            pool.release(std::move(slot));
+            return tuned;
+        }
+        pool.release(std::move(slot));
+        return conf;
+    };
+
+    // largest first, so the big fields do not end up alone at the end
+    std::vector<size_t> order(fields.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return fields[a].conf.num > fields[b].conf.num; });
+
+    // with shareTuning, the first field of each shape is compressed first and the rest of the group after it, each
+    // with the index of the first field of its group in leaders
+    std::vector<size_t> first, rest, leaders;
+    std::map<std::vector<size_t>, size_t> groups;
+    for (auto i : order) {
+        if (shareTuning && fields[i].conf.cmprAlgo == ALGO_INTERP_LORENZO && !fields[i].conf.openmp) {
+            auto group = groups.find(fields[i].conf.dims);
+            if (group != groups.end()) {
+                rest.push_back(i);
+                leaders.push_back(group->second);
+                continue;
+            }
+            groups[fields[i].conf.dims] = i;
+        }
+        first.push_back(i);
+    }
+
+    std::vector<Config> tuned(fields.size());
+    ex.parallel_for(first.size(), [&](size_t k) { tuned[first[k]] = compress_field(first[k], fields[first[k]].conf); });
+    ex.parallel_for(rest.size(), [&](size_t k) {
+        size_t i = rest[k];
+        Config conf = fields[i].conf;
+        const Config &leader = tuned[leaders[k]];
+        // nothing to share if the first field was compressed losslessly
+        if (leader.cmprAlgo != ALGO_INTERP_LORENZO && leader.cmprAlgo != ALGO_LOSSLESS) {
+            apply_tuning(leader, conf);
+        }
+        compress_field(i, conf);
+    });
+    return total;
+}
+
+#endif
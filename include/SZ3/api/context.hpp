@@ -0,0 +1,116 @@
+#ifndef SZ3_CONTEXT_HPP
+#define SZ3_CONTEXT_HPP
+
+#include <memory>
+#include <vector>
+
+#include "SZ3/api/sz.hpp"
+#include "SZ3/lossless/Lossless_zstd.hpp"
+#include "SZ3/lossless/ZstdDictionary.hpp"
+#include "SZ3/utils/TuningCache.hpp"
+#include "SZ3/utils/Workspace.hpp"
+
+namespace SZ3 {
+/**
+ * Reusable compression context for workloads that compress same-shaped data repeatedly (e.g., every timestep).
+ * It owns the working copy of the input, the scratch buffers used by the compressors, and the zstd contexts, so they
+ * are allocated once and reused by later calls instead of being allocated in each call. It also keeps the auto-tuning
+ * results (see TuningCache) unless the caller has bound a tuning cache of its own. For small data, a zstd dictionary
+ * (see SZ_train_dictionary) can be set for both directions.
+ *
+ * A context is not thread-safe; use one context per thread.
+
+ example:
+ SZ3::Context<float> ctx;
+ for (int step = 0; step < steps; step++) {
+     size_t cmpSize = ctx.compress(conf, data, cmpData, cmpCap);
+     ...
+ }
+ */
+template <class T>
+class Context {
+   public:
+    Context() = default;
+
+    Context(const Context &) = delete;
+    Context &operator=(const Context &) = delete;
+
+    /**
+     * Same as SZ_compress(const SZ3::Config &config, const T *data, char *cmpData, size_t cmpCap)
+     */
+    size_t compress(const Config &conf, const T *data, char *cmpData, size_t cmpCap) {
+        BindScope<Workspace> wsScope(workspace);
+        BindScope<ZstdContext> zstdScope(zstd);
+        BindScope<ZstdDictionary> dictionaryScope(dictionary);
+        BindScope<TuningCache> tuningScope(TuningCache::current() ? nullptr : &tuning);
+        if (!SZ_compress_overwrites_input<T>(conf)) {
+            return SZ_compress(conf, data, cmpData, cmpCap);
+        }
+        dataCopy.assign(data, data + conf.num);
+        return SZ_compress_inplace(conf, dataCopy.data(), cmpData, cmpCap);
+    }
+
+    /**
+     * Same as SZ_decompress(SZ3::Config &config, char *cmpData, size_t cmpSize, T *&decData)
+     */
+    void decompress(Config &conf, char *cmpData, size_t cmpSize, T *&decData) {
+        BindScope<Workspace> wsScope(workspace);
+        BindScope<ZstdContext> zstdScope(zstd);
+        BindScope<ZstdDictionary> dictionaryScope(dictionary);
+        SZ_decompress(conf, cmpData, cmpSize, decData);
+    }
+
+    /**
+     * Compress and decompress with dict (nullptr for the one bound to the calling thread, if any). dict is not owned
+     * and must outlive its use.
+     */
+    void set_dictionary(ZstdDictionary *dict) { dictionary = dict; }
+
+   private:
+    std::vector<T> dataCopy;
+    Workspace workspace;
+    ZstdContext zstd;
+    TuningCache tuning;
+    ZstdDictionary *dictionary = nullptr;
+};
+}  // namespace SZ3
+
+/**
+ * API for training a zstd dictionary for data compressed in many small pieces of the same kind (e.g., HDF5 chunks or
+ * timesteps of a small field), where zstd alone cannot learn the headers and Huffman trees of each piece.
+ * The samples are compressed with config, and the dictionary is trained on the input of their zstd stage.
+ * Compression and decompression use the dictionary while it is bound to the calling thread (or set in a Context);
+ * store its content() with the data (e.g., as an HDF5 attribute) to rebuild it for decompression.
+ *
+ * @tparam T source data type
+ * @param config compression configuration, the same as for the data the dictionary is used for
+ * @param samples pieces of config.num values each; tens to hundreds of them
+ * @param capacity maximum dictionary size in bytes
+
+ example:
+ auto dict = SZ_train_dictionary(conf, std::vector<const float *>{chunk0, chunk1, ...});
+ SZ3::BindScope<SZ3::ZstdDictionary> scope(*dict);
+ size_t cmpSize = SZ_compress(conf, chunk, cmpData, cmpCap);
+ save_attribute(dict->content());
+ ...
+ SZ3::ZstdDictionary loaded(load_attribute());
+ SZ3::BindScope<SZ3::ZstdDictionary> scope(loaded);
+ SZ_decompress(conf, cmpData, cmpSize, decData);
+ */
+template <class T>
+std::unique_ptr<SZ3::ZstdDictionary> SZ_train_dictionary(const SZ3::Config &config,
+                                                         const std::vector<const T *> &samples,
+                                                         size_t capacity = SZ3::SZ_ZSTD_DICT_CAPACITY) {
+    using namespace SZ3;
+    Config conf(config);
+    conf.openmp = false;
+    ZstdDictionaryTrainer trainer;
+    BindScope<ZstdDictionaryTrainer> trainerScope(trainer);
+    std::vector<char> cmpData(SZ_compress_bound<T>(conf));
+    for (auto sample : samples) {
+        SZ_compress(conf, sample, cmpData.data(), cmpData.size());
+    }
+    return trainer.train(capacity, conf.zstdLevel);
+}
+
+#endif
@@ -4,12 +4,15 @@
 #include "SZ3/api/impl/SZAlgoLorenzoReg.hpp"
 #include "SZ3/compressor/specialized/SZBlockInterpolationCompressor.hpp"
 #include "SZ3/decomposition/InterpolationDecomposition.hpp"
+#include "SZ3/executor/Executor_omp.hpp"
 #include "SZ3/lossless/Lossless_zstd.hpp"
-#include "SZ3/quantizer/LinearQuantizer.hpp"
+#include "SZ3/quantizer/IntegerQuantizer.hpp"
 #include "SZ3/utils/Config.hpp"
 #include "SZ3/utils/Extraction.hpp"
 #include "SZ3/utils/QuantOptimizatioin.hpp"
 #include "SZ3/utils/Statistic.hpp"
+#include "SZ3/utils/TuningCache.hpp"
+#include "SZ3/utils/Workspace.hpp"
 
 namespace SZ3 {
 template <class T, uint N>
@@ -19,8 +22,8 @@ size_t SZ_compress_Interp(Config &conf, T *data, uchar *cmpData, size_t cmpCap)
     calAbsErrorBound(conf, data);
 
     auto sz = make_compressor_sz_generic<T, N>(
-        make_decomposition_interpolation<T, N>(conf, LinearQuantizer<T>(conf.absErrorBound, conf.quantbinCnt / 2)),
-        HuffmanEncoder<int>(), Lossless_zstd());
+        make_decomposition_interpolation<T, N>(conf, DefaultQuantizer<T>(conf.absErrorBound, conf.quantbinCnt / 2)),
+        HuffmanEncoder<int>(), Lossless_zstd(conf));
     return sz->compress(conf, data, cmpData, cmpCap);
     //        return cmpData;
 }
@@ -30,8 +33,8 @@ void SZ_decompress_Interp(const Config &conf, const uchar *cmpData, size_t cmpSi
     assert(conf.cmprAlgo == ALGO_INTERP);
     auto cmpDataPos = cmpData;
     auto sz = make_compressor_sz_generic<T, N>(
-        make_decomposition_interpolation<T, N>(conf, LinearQuantizer<T>(conf.absErrorBound, conf.quantbinCnt / 2)),
-        HuffmanEncoder<int>(), Lossless_zstd());
+        make_decomposition_interpolation<T, N>(conf, DefaultQuantizer<T>(conf.absErrorBound, conf.quantbinCnt / 2)),
+        HuffmanEncoder<int>(), Lossless_zstd(conf));
     sz->decompress(conf, cmpDataPos, cmpSize, decData);
 }
 
@@ -47,10 +50,13 @@ double do_not_use_this_interp_compress_block_test(T *data, std::vector<size_t> d
     conf.blockSize = block_size;
     conf.interpAlgo = interp_op;
     conf.interpDirection = direction_op;
-    auto sz = SZBlockInterpolationCompressor<T, N, LinearQuantizer<T>, HuffmanEncoder<int>, Lossless_zstd>(
-        LinearQuantizer<T>(eb), HuffmanEncoder<int>(), Lossless_zstd());
+    auto sz = SZBlockInterpolationCompressor<T, N, DefaultQuantizer<T>, HuffmanEncoder<int>, Lossless_zstd>(
+        DefaultQuantizer<T>(eb), HuffmanEncoder<int>(), Lossless_zstd());
 
     size_t outSize = sz.compress(conf, data1.data(), buffer, bufferCap);
+    if (outSize == 0) {
+        return 0;
+    }
 
     auto compression_ratio = num * sizeof(T) * 1.0 / outSize;
     return compression_ratio;
@@ -72,37 +78,65 @@ size_t SZ_compress_Interp_lorenzo(Config &conf, T *data, uchar *cmpData, size_t
         return SZ_compress_Interp<T, N>(conf, data, cmpData, cmpCap);
     }
 
+    // settings tuned on earlier data of the same field
+    auto cache = TuningCache::current();
+    double statistic = cache ? tuning_statistic(sampling_data, conf.absErrorBound) : 0;
+    Config tuned;
+    if (cache != nullptr && cache->find(conf, statistic, tuned)) {
+        apply_tuning(tuned, conf);
+        if (conf.cmprAlgo == ALGO_INTERP) {
+            return SZ_compress_Interp<T, N>(conf, data, cmpData, cmpCap);
+        }
+        return SZ_compress_LorenzoReg<T, N>(conf, data, cmpData, cmpCap);
+    }
+
     double best_lorenzo_ratio = 0, best_interp_ratio = 0, ratio;
-    size_t bufferCap = conf.num * sizeof(T);
-    auto buffer = static_cast<uchar *>(malloc(bufferCap));
+    auto sample_ratio = [&](size_t sampleOutSize) {
+        return sampleOutSize == 0 ? 0.0 : sampling_num * 1.0 * sizeof(T) / sampleOutSize;
+    };
+    // one buffer for each of the trials that run at the same time
+    size_t bufferCap = ZSTD_compressBound(sampling_num * sizeof(T));
+    ScratchBuffer scratch(WS_TUNING, 3 * bufferCap);
+    auto buffer = scratch.data();
     Config lorenzo_config = conf;
-    {
-        // test lorenzo
-        lorenzo_config.cmprAlgo = ALGO_LORENZO_REG;
-        lorenzo_config.setDims(sample_dims.begin(), sample_dims.end());
-        lorenzo_config.lorenzo = true;
-        lorenzo_config.lorenzo2 = true;
-        lorenzo_config.regression = false;
-        lorenzo_config.regression2 = false;
-        lorenzo_config.openmp = false;
-        lorenzo_config.blockSize = 5;
-        //        lorenzo_config.quantbinCnt = 65536 * 2;
-        std::vector<T> data1(sampling_data);
-        size_t sampleOutSize = SZ_compress_LorenzoReg<T, N>(lorenzo_config, data1.data(), buffer, bufferCap);
-        //            delete[]cmprData;
-        //    printf("Lorenzo ratio = %.2f\n", ratio);
-        best_lorenzo_ratio = sampling_num * 1.0 * sizeof(T) / sampleOutSize;
-    }
+    lorenzo_config.cmprAlgo = ALGO_LORENZO_REG;
+    lorenzo_config.setDims(sample_dims.begin(), sample_dims.end());
+    lorenzo_config.lorenzo = true;
+    lorenzo_config.lorenzo2 = true;
+    lorenzo_config.regression = false;
+    lorenzo_config.regression2 = false;
+    lorenzo_config.openmp = false;
+    lorenzo_config.blockSize = 5;
+    //        lorenzo_config.quantbinCnt = 65536 * 2;
+
+    // lorenzo, linear and cubic interp are independent trials, run them on the executor bound to the current thread
+    // or on OpenMP
+    Executor_omp fallback(conf.nThreads);
+    auto &executor = concepts::ExecutorInterface::current() ? *concepts::ExecutorInterface::current() : fallback;
+    const uint8_t interp_ops[] = {INTERP_ALGO_LINEAR, INTERP_ALGO_CUBIC};
+    double trial_ratios[3];
+    executor.parallel_for(3, [&](size_t t) {
+        auto trial_buffer = buffer + t * bufferCap;
+        if (t == 0) {
+            // test lorenzo
+            std::vector<T> data1(sampling_data);
+            trial_ratios[t] = sample_ratio(
+                SZ_compress_LorenzoReg<T, N>(lorenzo_config, data1.data(), trial_buffer, bufferCap));
+        } else {
+            // test interp
+            trial_ratios[t] = do_not_use_this_interp_compress_block_test<T, N>(
+                sampling_data.data(), sample_dims, sampling_num, conf.absErrorBound, interp_ops[t - 1],
+                conf.interpDirection, sampling_block, trial_buffer, bufferCap);
+        }
+    });
+    best_lorenzo_ratio = trial_ratios[0];
 
     {
         // tune interp
-        for (auto &interp_op : {INTERP_ALGO_LINEAR, INTERP_ALGO_CUBIC}) {
-            ratio = do_not_use_this_interp_compress_block_test<T, N>(
-                sampling_data.data(), sample_dims, sampling_num, conf.absErrorBound, interp_op, conf.interpDirection,
-                sampling_block, buffer, bufferCap);
-            if (ratio > best_interp_ratio) {
-                best_interp_ratio = ratio;
-                conf.interpAlgo = interp_op;
+        for (size_t k = 0; k < 2; k++) {
+            if (trial_ratios[k + 1] > best_interp_ratio) {
+                best_interp_ratio = trial_ratios[k + 1];
+                conf.interpAlgo = interp_ops[k];
             }
         }
 
@@ -120,6 +154,9 @@ size_t SZ_compress_Interp_lorenzo(Config &conf, T *data, uchar *cmpData, size_t
     size_t cmpSize = 0;
     if (useInterp) {
         conf.cmprAlgo = ALGO_INTERP;
+        if (cache != nullptr) {
+            cache->insert(conf, statistic);
+        }
         cmpSize = SZ_compress_Interp<T, N>(conf, data, cmpData, cmpCap);
     } else {
         // further tune lorenzo
@@ -131,7 +168,7 @@ size_t SZ_compress_Interp_lorenzo(Config &conf, T *data, uchar *cmpData, size_t
             lorenzo_config.pred_dim = 2;
             size_t sampleOutSize =
                 SZ_compress_LorenzoReg<T, N>(lorenzo_config, sampling_data.data(), buffer, bufferCap);
-            ratio = sampling_num * 1.0 * sizeof(T) / sampleOutSize;
+            ratio = sample_ratio(sampleOutSize);
             if (ratio > best_lorenzo_ratio * 1.02) {
                 best_lorenzo_ratio = ratio;
             } else {
@@ -145,7 +182,7 @@ size_t SZ_compress_Interp_lorenzo(Config &conf, T *data, uchar *cmpData, size_t
             size_t sampleOutSize =
                 SZ_compress_LorenzoReg<T, N>(lorenzo_config, sampling_data.data(), buffer, bufferCap);
             //                delete[]cmprData;
-            ratio = sampling_num * 1.0 * sizeof(T) / sampleOutSize;
+            ratio = sample_ratio(sampleOutSize);
             if (ratio > best_lorenzo_ratio * 1.02) {
                 best_lorenzo_ratio = ratio;
             } else {
@@ -154,11 +191,13 @@ size_t SZ_compress_Interp_lorenzo(Config &conf, T *data, uchar *cmpData, size_t
         }
         lorenzo_config.setDims(conf.dims.begin(), conf.dims.end());
         conf = lorenzo_config;
+        if (cache != nullptr) {
+            cache->insert(conf, statistic);
+        }
         //            double tuning_time = timer.stop();
         cmpSize = SZ_compress_LorenzoReg<T, N>(conf, data, cmpData, cmpCap);
     }
 
-    free(buffer);
     return cmpSize;
 }
 }  // namespace SZ3
@@ -13,7 +13,7 @@
 #include "SZ3/predictor/LorenzoPredictor.hpp"
 #include "SZ3/predictor/PolyRegressionPredictor.hpp"
 #include "SZ3/predictor/RegressionPredictor.hpp"
-#include "SZ3/quantizer/LinearQuantizer.hpp"
+#include "SZ3/quantizer/IntegerQuantizer.hpp"
 #include "SZ3/utils/Config.hpp"
 #include "SZ3/utils/Extraction.hpp"
 #include "SZ3/utils/Iterator.hpp"
@@ -76,15 +76,15 @@ size_t SZ_compress_LorenzoReg(Config &conf, T *data, uchar *cmpData, size_t cmpC
     assert(conf.cmprAlgo == ALGO_LORENZO_REG);
     calAbsErrorBound(conf, data);
 
-    auto quantizer = LinearQuantizer<T>(conf.absErrorBound, conf.quantbinCnt / 2);
+    auto quantizer = DefaultQuantizer<T>(conf.absErrorBound, conf.quantbinCnt / 2);
     if ((N == 3 && !conf.regression2) || (N == 1 && !conf.regression && !conf.regression2)) {
         // use fast version for 3D
         auto sz = make_compressor_sz_generic<T, N>(make_decomposition_lorenzo_regression<T, N>(conf, quantizer),
-                                                   HuffmanEncoder<int>(), Lossless_zstd());
+                                                   HuffmanEncoder<int>(), Lossless_zstd(conf));
         return sz->compress(conf, data, cmpData, cmpCap);
     } else {
-        auto sz =
-            make_compressor_typetwo_lorenzo_regression<T, N>(conf, quantizer, HuffmanEncoder<int>(), Lossless_zstd());
+        auto sz = make_compressor_typetwo_lorenzo_regression<T, N>(conf, quantizer, HuffmanEncoder<int>(),
+                                                                   Lossless_zstd(conf));
         return sz->compress(conf, data, cmpData, cmpCap);
     }
     //        return cmpData;
@@ -95,17 +95,17 @@ void SZ_decompress_LorenzoReg(const Config &conf, const uchar *cmpData, size_t c
     assert(conf.cmprAlgo == ALGO_LORENZO_REG);
 
     auto cmpDataPos = cmpData;
-    LinearQuantizer<T> quantizer;
+    DefaultQuantizer<T> quantizer;
     if ((N == 3 && !conf.regression2) || (N == 1 && !conf.regression && !conf.regression2)) {
         // use fast version for 3D
         auto sz = make_compressor_sz_generic<T, N>(make_decomposition_lorenzo_regression<T, N>(conf, quantizer),
-                                                   HuffmanEncoder<int>(), Lossless_zstd());
+                                                   HuffmanEncoder<int>(), Lossless_zstd(conf));
         sz->decompress(conf, cmpDataPos, cmpSize, decData);
         return;
 
     } else {
-        auto sz =
-            make_compressor_typetwo_lorenzo_regression<T, N>(conf, quantizer, HuffmanEncoder<int>(), Lossless_zstd());
+        auto sz = make_compressor_typetwo_lorenzo_regression<T, N>(conf, quantizer, HuffmanEncoder<int>(),
+                                                                   Lossless_zstd(conf));
         sz->decompress(conf, cmpDataPos, cmpSize, decData);
         return;
     }
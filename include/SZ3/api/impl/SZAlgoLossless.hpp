@@ -0,0 +1,64 @@
+#ifndef SZ3_SZALGO_LOSSLESS_HPP
+#define SZ3_SZALGO_LOSSLESS_HPP
+
+#include <stdexcept>
+
+#include "SZ3/lossless/Lossless_zstd.hpp"
+#include "SZ3/preprocessor/Shuffle.hpp"
+#include "SZ3/utils/Config.hpp"
+#include "SZ3/utils/MemoryUtil.hpp"
+#include "SZ3/utils/Workspace.hpp"
+
+namespace SZ3 {
+/**
+ * Lossless compression (absErrorBound == 0, or below 1 for integer data): the values are shuffled (see
+ * preprocessor/Shuffle.hpp) as set by conf.losslessShuffle and conf.losslessPredictor, then compressed by zstd.
+ * The shuffle and predictor are stored in front of the zstd data, so decompression does not depend on conf for them.
+ */
+template <class T, uint N>
+size_t SZ_compress_lossless(Config &conf, const T *data, uchar *cmpData, size_t cmpCap) {
+    assert(N == conf.N);
+    assert(conf.cmprAlgo == ALGO_LOSSLESS);
+    if (conf.losslessShuffle > SHUFFLE_BIT || conf.losslessPredictor > LOSSLESS_PRED_DELTA) {
+        throw std::invalid_argument("invalid shuffle or predictor for lossless compression");
+    }
+    if (cmpCap < 2) {
+        return 0;
+    }
+    size_t bytes = conf.num * sizeof(T);
+    ScratchBuffer shuffled(WS_LOSSLESS_SRC, bytes);
+    ScratchBuffer tmp(WS_SHUFFLE, conf.losslessShuffle == SHUFFLE_BIT ? bytes : 0);
+    Shuffle<T>(conf.losslessShuffle, conf.losslessPredictor).encode(data, conf.num, shuffled.data(), tmp.data());
+
+    uchar *cmpDataPos = cmpData;
+    write(conf.losslessShuffle, cmpDataPos);
+    write(conf.losslessPredictor, cmpDataPos);
+    auto zstd = Lossless_zstd(conf);
+    size_t zstdSize = zstd.compress(shuffled.data(), bytes, cmpDataPos, cmpCap - 2);
+    return zstdSize == 0 ? 0 : 2 + zstdSize;
+}
+
+template <class T, uint N>
+void SZ_decompress_lossless(Config &conf, const uchar *cmpData, size_t cmpSize, T *decData) {
+    assert(conf.cmprAlgo == ALGO_LOSSLESS);
+    if (cmpSize < 2) {
+        throw std::runtime_error("truncated lossless data");
+    }
+    const uchar *cmpDataPos = cmpData;
+    read(conf.losslessShuffle, cmpDataPos);
+    read(conf.losslessPredictor, cmpDataPos);
+    if (conf.losslessShuffle > SHUFFLE_BIT || conf.losslessPredictor > LOSSLESS_PRED_DELTA) {
+        throw std::runtime_error("corrupted lossless data");
+    }
+
+    size_t bytes = conf.num * sizeof(T);
+    ScratchBuffer shuffled(WS_LOSSLESS_DST, bytes);
+    ScratchBuffer tmp(WS_SHUFFLE, conf.losslessShuffle == SHUFFLE_BIT ? bytes : 0);
+    auto zstd = Lossless_zstd(conf);
+    if (zstd.decompress(cmpDataPos, cmpSize - 2, shuffled.data(), bytes) != bytes) {
+        throw std::runtime_error("corrupted lossless data");
+    }
+    Shuffle<T>(conf.losslessShuffle, conf.losslessPredictor).decode(shuffled.data(), conf.num, decData, tmp.data());
+}
+}  // namespace SZ3
+#endif
@@ -4,8 +4,9 @@
 #include "SZ3/compressor/SZGenericCompressor.hpp"
 #include "SZ3/decomposition/NoPredictionDecomposition.hpp"
 #include "SZ3/encoder/HuffmanEncoder.hpp"
+#include "SZ3/lossless/Lossless_bypass.hpp"
 #include "SZ3/lossless/Lossless_zstd.hpp"
-#include "SZ3/quantizer/LinearQuantizer.hpp"
+#include "SZ3/quantizer/IntegerQuantizer.hpp"
 #include "SZ3/utils/Config.hpp"
 
 namespace SZ3 {
@@ -15,9 +16,21 @@ size_t SZ_compress_nopred(Config &conf, T *data, uchar *cmpData, size_t cmpCap)
     assert(conf.cmprAlgo == ALGO_NOPRED);
     calAbsErrorBound(conf, data);
 
+    // conf.lossless == 0 skips zstd, the cheapest pipeline (see SZ_budget_variant)
+    if (conf.lossless == 0) {
+        auto sz = make_compressor_sz_generic<T, N>(
+            make_decomposition_noprediction<T, N>(conf, DefaultQuantizer<T>(conf.absErrorBound, conf.quantbinCnt / 2)),
+            HuffmanEncoder<int>(), Lossless_bypass());
+        // decompression expects at most the size of the original data, otherwise zstd is used after all
+        size_t cmpSize = sz->compress(conf, data, cmpData, std::min(cmpCap, conf.num * sizeof(T)));
+        if (cmpSize != 0) {
+            return cmpSize;
+        }
+        conf.lossless = 1;
+    }
     auto sz = make_compressor_sz_generic<T, N>(
-        make_decomposition_noprediction<T, N>(conf, LinearQuantizer<T>(conf.absErrorBound, conf.quantbinCnt / 2)),
-        HuffmanEncoder<int>(), Lossless_zstd());
+        make_decomposition_noprediction<T, N>(conf, DefaultQuantizer<T>(conf.absErrorBound, conf.quantbinCnt / 2)),
+        HuffmanEncoder<int>(), Lossless_zstd(conf));
     return sz->compress(conf, data, cmpData, cmpCap);
     //        return cmpData;
 }
@@ -26,9 +39,17 @@ template <class T, uint N>
 void SZ_decompress_nopred(const Config &conf, const uchar *cmpData, size_t cmpSize, T *decData) {
     assert(conf.cmprAlgo == ALGO_NOPRED);
     auto cmpDataPos = cmpData;
+    // streams with the legacy header always used zstd, Config::load resets their lossless setting to 1
+    if (conf.lossless == 0) {
+        auto sz = make_compressor_sz_generic<T, N>(
+            make_decomposition_noprediction<T, N>(conf, DefaultQuantizer<T>(conf.absErrorBound, conf.quantbinCnt / 2)),
+            HuffmanEncoder<int>(), Lossless_bypass());
+        sz->decompress(conf, cmpDataPos, cmpSize, decData);
+        return;
+    }
     auto sz = make_compressor_sz_generic<T, N>(
-        make_decomposition_noprediction<T, N>(conf, LinearQuantizer<T>(conf.absErrorBound, conf.quantbinCnt / 2)),
-        HuffmanEncoder<int>(), Lossless_zstd());
+        make_decomposition_noprediction<T, N>(conf, DefaultQuantizer<T>(conf.absErrorBound, conf.quantbinCnt / 2)),
+        HuffmanEncoder<int>(), Lossless_zstd(conf));
     sz->decompress(conf, cmpDataPos, cmpSize, decData);
 }
 
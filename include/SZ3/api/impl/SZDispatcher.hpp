@@ -3,39 +3,246 @@
 
 #include "SZ3/api/impl/SZAlgoInterp.hpp"
 #include "SZ3/api/impl/SZAlgoLorenzoReg.hpp"
+#include "SZ3/api/impl/SZAlgoLossless.hpp"
 #include "SZ3/api/impl/SZAlgoNopred.hpp"
+#include "SZ3/lossless/Lossless_zstd.hpp"
 #include "SZ3/utils/Config.hpp"
+#include "SZ3/utils/Extraction.hpp"
+#include "SZ3/utils/Half.hpp"
 #include "SZ3/utils/Statistic.hpp"
+#include "SZ3/utils/TuningCache.hpp"
 
 namespace SZ3 {
+/**
+ * Whether the pipeline selected by conf writes reconstructed values back into the input data.
+ * Lossless, no-prediction, and the fast lorenzo paths (which keep reconstructed neighbors in a rolling buffer)
+ * only read the input, so callers can pass their own buffer without making a copy first. Half precision data is only
+ * read as well, the pipelines work on a copy in float (see SZ_compress_half).
+ */
+template <class T>
+bool SZ_compress_overwrites_input(const Config &conf) {
+    if (is_half<T>::value) {
+        return false;
+    } else if ((conf.errorBoundMode == EB_ABS && conf.absErrorBound == 0) || conf.cmprAlgo == ALGO_LOSSLESS) {
+        return false;
+    } else if (conf.cmprAlgo == ALGO_NOPRED) {
+        return false;
+    } else if (conf.cmprAlgo == ALGO_LORENZO_REG) {
+        return !((conf.N == 3 && !conf.regression2) || (conf.N == 1 && !conf.regression && !conf.regression2));
+    }
+    return true;
+}
+
+/**
+ * upper bound of the output size of SZ_compress_dispatcher for num elements.
+ * Every pipeline ends with the lossless stage, whose input never exceeds the size of the original data (decompression
+ * relies on this too); ALGO_LOSSLESS adds a 2-byte header.
+ */
+template <class T>
+size_t SZ_compress_dispatcher_bound(size_t num) {
+    return ZSTD_compressBound(num * sizeof(T)) + 2;
+}
+
+template <class T, uint N>
+void calAbsErrorBoundFromRatio(Config &conf, const T *data, double *slope = nullptr);
+
+template <class T, uint N>
+size_t SZ_compress_dispatcher(Config &conf, T *data, uchar *cmpData, size_t cmpCap);
+
+/**
+ * Compress half precision data (see Half.hpp) with the pipelines of float, on a copy of the data in float.
+ * The decompressed values are rounded to T, which moves them by at most half the spacing of T, and by no more than
+ * their distance to the original value (a value of T); the error bound of the float pipeline leaves room for it.
+ * @return compressed size, or 0 if the quantized data is too large (the caller keeps the 16-bit values instead)
+ */
+template <class T, uint N>
+size_t SZ_compress_half(Config &conf, const T *data, uchar *cmpData, size_t cmpCap) {
+    std::vector<float> values(conf.num);
+    float maxAbs = 0;
+    for (size_t i = 0; i < conf.num; i++) {
+        values[i] = data[i];
+        maxAbs = std::max(maxAbs, std::fabs(values[i]));
+    }
+    double eb = conf.absErrorBound;
+    conf.absErrorBound = eb - std::min<double>(eb, T::spacing(maxAbs + static_cast<float>(eb))) / 2;
+    size_t cmpSize = SZ_compress_dispatcher<float, N>(conf, values.data(), cmpData, cmpCap);
+    return conf.cmprAlgo == ALGO_LOSSLESS ? 0 : cmpSize;
+}
+
 template <class T, uint N>
 size_t SZ_compress_dispatcher(Config &conf, T *data, uchar *cmpData, size_t cmpCap) {
     assert(N == conf.N);
+    if (conf.errorBoundMode == EB_RATIO || conf.errorBoundMode == EB_BITRATE) {
+        calAbsErrorBoundFromRatio<T, N>(conf, data);
+    }
     calAbsErrorBound(conf, data);
 
     //        char *cmpData;
-    if (conf.absErrorBound == 0) {
-        auto zstd = Lossless_zstd();
-        return zstd.compress(reinterpret_cast<uchar *>(data), conf.num * sizeof(T), cmpData, cmpCap);
+    // an error bound below 1 leaves no error to integer data
+    if (conf.absErrorBound == 0 || conf.cmprAlgo == ALGO_LOSSLESS ||
+        (std::is_integral<T>::value && conf.absErrorBound < 1)) {
+        conf.cmprAlgo = ALGO_LOSSLESS;
+        conf.absErrorBound = 0;
+        return SZ_compress_lossless<T, N>(conf, data, cmpData, cmpCap);
+    }
+    size_t cmpSize = 0;
+    if constexpr (is_half<T>::value) {
+        cmpSize = SZ_compress_half<T, N>(conf, data, cmpData, cmpCap);
     } else if (conf.cmprAlgo == ALGO_LORENZO_REG) {
-        return SZ_compress_LorenzoReg<T, N>(conf, data, cmpData, cmpCap);
+        cmpSize = SZ_compress_LorenzoReg<T, N>(conf, data, cmpData, cmpCap);
     } else if (conf.cmprAlgo == ALGO_INTERP) {
-        return SZ_compress_Interp<T, N>(conf, data, cmpData, cmpCap);
+        cmpSize = SZ_compress_Interp<T, N>(conf, data, cmpData, cmpCap);
     } else if (conf.cmprAlgo == ALGO_INTERP_LORENZO) {
-        return SZ_compress_Interp_lorenzo<T, N>(conf, data, cmpData, cmpCap);
+        cmpSize = SZ_compress_Interp_lorenzo<T, N>(conf, data, cmpData, cmpCap);
     } else if (conf.cmprAlgo == ALGO_NOPRED) {
-        return SZ_compress_nopred<T, N>(conf, data, cmpData, cmpCap);
+        cmpSize = SZ_compress_nopred<T, N>(conf, data, cmpData, cmpCap);
+    } else {
+        return 0;
+    }
+    if (cmpSize == 0 && cmpCap >= SZ_compress_dispatcher_bound<T>(conf.num)) {
+        // the quantized data is larger than the data (e.g., an error bound small for the range of integer data); the
+        // data, if overwritten by the pipeline, holds values within the error bound, which are kept as they are
+        conf.cmprAlgo = ALGO_LOSSLESS;
+        conf.absErrorBound = 0;
+        cmpSize = SZ_compress_lossless<T, N>(conf, data, cmpData, cmpCap);
     }
-    return 0;
+    return cmpSize;
     //        return cmpData;
 }
 
+/**
+ * target bit rate (bits per value) of the EB_RATIO or EB_BITRATE mode
+ */
+template <class T>
+double SZ_target_bitrate(const Config &conf) {
+    double target = conf.errorBoundMode == EB_RATIO ? sizeof(T) * 8.0 / conf.targetRatio : conf.targetBitrate;
+    if (!(target > 0)) {
+        throw std::invalid_argument("the target compression ratio or bit rate must be positive");
+    }
+    return target;
+}
+
+/**
+ * Search log2 of the error bound for which rate(logEb), the bit rate, is within tolerance of target.
+ * log2 of the bit rate drops roughly linearly as the error bound doubles; steps are secant steps on the last two trials
+ * in that scale, kept inside the bracket once the target is bracketed. The rate is not strictly monotonic (the tuned
+ * settings change with the error bound), so the best trial is returned rather than the end of the bracket.
+ * @param slope initial drop of log2(rate) per doubling of the error bound, updated with the measured one
+ * @return the log2(eb) of the trial with the highest rate not above target (with tolerance), or of the lowest rate if
+ * none is
+ */
+template <class Rate>
+double SZ_search_log_eb(Rate rate, double target, double logEb, double &slope, double minLogEb, double maxLogEb,
+                        int maxTrials, double tolerance) {
+    double lo = -INFINITY, hi = INFINITY;
+    double bestLogEb = logEb, bestRate = NAN;
+    double prevLogEb = NAN, prevLogRate = NAN;
+    for (int i = 0; i < maxTrials; i++) {
+        double r = rate(logEb);
+        bool fits = r <= target * (1 + tolerance);
+        bool bestFits = bestRate <= target * (1 + tolerance);
+        if (std::isnan(bestRate) || (fits && (!bestFits || r > bestRate)) || (!fits && !bestFits && r < bestRate)) {
+            bestLogEb = logEb;
+            bestRate = r;
+        }
+        if (std::fabs(r - target) <= tolerance * target) {
+            break;
+        }
+        if (r > target) {
+            lo = logEb;
+        } else {
+            hi = logEb;
+        }
+        double logRate = std::log2(r);
+        if (!std::isnan(prevLogRate) && prevLogRate != logRate) {
+            double measured = (prevLogRate - logRate) / (logEb - prevLogEb);
+            if (measured > 0) {
+                slope = std::min(std::max(measured, 0.02), 2.0);
+            }
+        }
+        prevLogEb = logEb;
+        prevLogRate = logRate;
+
+        double next = logEb + std::min(std::max((logRate - std::log2(target)) / slope, -4.0), 4.0);
+        if (std::isfinite(lo) && std::isfinite(hi)) {
+            if (std::fabs(hi - lo) < 0.01) {
+                break;
+            }
+            next = std::min(std::max(next, std::min(lo, hi) + 0.1 * std::fabs(hi - lo)),
+                            std::max(lo, hi) - 0.1 * std::fabs(hi - lo));
+        }
+        next = std::min(std::max(next, minLogEb), maxLogEb);
+        if (next == logEb) {
+            // the target cannot be reached within [minLogEb, maxLogEb]
+            break;
+        }
+        logEb = next;
+    }
+    return bestLogEb;
+}
+
+/**
+ * Convert the EB_RATIO or EB_BITRATE mode of conf to an absolute error bound, estimated with trial compressions of a
+ * sample of the data (see sampling_box in Extraction.hpp).
+ * The ratio of the whole data may differ from that of the sample; SZ_compress corrects the estimate with the whole data
+ * (see SZ_compress_ratio).
+ * @param slope if not null, the measured drop of log2 of the bit rate per doubling of the error bound
+ */
+template <class T, uint N>
+void calAbsErrorBoundFromRatio(Config &conf, const T *data, double *slope) {
+    double target = SZ_target_bitrate<T>(conf);
+    double range = value_range(conf, data);
+    // the target is resolved, the decoder needs neither it nor its room in the header
+    conf.errorBoundMode = EB_ABS;
+    conf.targetRatio = 0;
+    conf.targetBitrate = 0;
+    if (range <= 0) {
+        // constant data, stored losslessly
+        conf.absErrorBound = 0;
+        return;
+    }
+
+    std::vector<size_t> sample_dims;
+    std::vector<T> sample = sampling_box<T, N>(data, conf.dims, sample_dims);
+    Config trial = conf;
+    trial.setDims(sample_dims.begin(), sample_dims.end());
+    trial.openmp = false;
+    std::vector<T> trialData(trial.num);
+    std::vector<uchar> buffer(SZ_compress_dispatcher_bound<T>(trial.num));
+    // trials with close error bounds reuse the tuned settings; the caller's cache is left alone
+    TuningCache trialCache(0.5);
+    BindScope<TuningCache> cacheScope(trialCache);
+    auto bitrate = [&](double logEb) {
+        Config c = trial;
+        c.absErrorBound = std::exp2(logEb);
+        std::copy(sample.begin(), sample.end(), trialData.begin());
+        size_t size = SZ_compress_dispatcher<T, N>(c, trialData.data(), buffer.data(), buffer.size());
+        return size == 0 ? sizeof(T) * 8.0 : size * 8.0 / trial.num;
+    };
+
+    double s = 0.3;
+    double maxLogEb = std::log2(range);
+    conf.absErrorBound =
+        std::exp2(SZ_search_log_eb(bitrate, target, maxLogEb - 10, s, maxLogEb - 60, maxLogEb, 10, 0.03));
+    if (slope != nullptr) {
+        *slope = s;
+    }
+}
+
 template <class T, uint N>
 void SZ_decompress_dispatcher(Config &conf, const uchar *cmpData, size_t cmpSize, T *decData) {
-    if (conf.absErrorBound == 0) {
-        auto zstd = Lossless_zstd();
+    if (conf.cmprAlgo == ALGO_LOSSLESS) {
+        SZ_decompress_lossless<T, N>(conf, cmpData, cmpSize, decData);
+    } else if (conf.absErrorBound == 0) {
+        // data compressed before ALGO_LOSSLESS: zstd on the values as they are
+        auto zstd = Lossless_zstd(conf);
         auto zstdDstCap = conf.num * sizeof(T);
         zstd.decompress(cmpData, cmpSize, reinterpret_cast<uchar *>(decData), zstdDstCap);
+    } else if constexpr (is_half<T>::value) {
+        // compressed by the pipelines of float, see SZ_compress_half
+        std::vector<float> values(conf.num);
+        SZ_decompress_dispatcher<float, N>(conf, cmpData, cmpSize, values.data());
+        half_from_float(values.data(), conf.num, decData);
     } else if (conf.cmprAlgo == ALGO_LORENZO_REG) {
         SZ_decompress_LorenzoReg<T, N>(conf, cmpData, cmpSize, decData);
     } else if (conf.cmprAlgo == ALGO_INTERP) {
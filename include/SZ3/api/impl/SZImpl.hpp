@@ -3,32 +3,222 @@
 
 #include "SZ3/api/impl/SZDispatcher.hpp"
 #include "SZ3/api/impl/SZImplOMP.hpp"
+#include "SZ3/api/impl/SZTimeBudget.hpp"
 #include "SZ3/def.hpp"
 
 namespace SZ3 {
+/**
+ * Resolve the time budget of conf (see SZ_fit_time_budget) for SZ_compress_impl
+ */
+template <class T, uint N>
+void SZ_compress_time_budget(Config &conf, const T *data) {
+    if (conf.timeBudget > 0 || conf.minThroughput > 0) {
+        Executor_omp fallback(conf.nThreads);
+        SZ_fit_time_budget<T, N>(conf, data, conf.openmp ? SZ_executor(fallback).concurrency() : 1);
+    }
+}
+
+/**
+ * Compress with the EB_RATIO or EB_BITRATE mode of conf.
+ * The error bound estimated on a sample (see calAbsErrorBoundFromRatio) is checked on the whole data and corrected
+ * with at most two more compressions; the output is that of the closest compression meeting the target.
+ * @param compress compresses the whole data into cmpData with the absolute error bound of its Config
+ */
+template <class T, uint N, class Compress>
+size_t SZ_compress_ratio(Config &conf, const T *data, Compress compress) {
+    double target = SZ_target_bitrate<T>(conf);
+    double slope = 0.3;
+    Config estimate(conf);
+    calAbsErrorBoundFromRatio<T, N>(estimate, data, &slope);
+    // the pipeline is chosen once, the time budget applies to each compression of the search
+    SZ_compress_time_budget<T, N>(estimate, data);
+    if (estimate.absErrorBound == 0 || estimate.cmprAlgo == ALGO_LOSSLESS) {
+        conf = estimate;
+        return compress(conf);
+    }
+
+    Config compressed;
+    size_t cmpSize = 0;
+    double compressedLogEb = NAN;
+    auto bitrate = [&](double logEb) {
+        compressed = estimate;
+        compressed.absErrorBound = std::exp2(logEb);
+        cmpSize = compress(compressed);
+        compressedLogEb = logEb;
+        return cmpSize == 0 ? sizeof(T) * 8.0 : cmpSize * 8.0 / conf.num;
+    };
+    double maxLogEb = std::log2(estimate.valueRange);
+    double logEb = SZ_search_log_eb(bitrate, target, std::log2(estimate.absErrorBound), slope, maxLogEb - 60, maxLogEb,
+                                    3, 0.03);
+    if (logEb != compressedLogEb) {
+        bitrate(logEb);
+    }
+    conf = compressed;
+    return cmpSize;
+}
+
 template <class T, uint N>
 size_t SZ_compress_impl(Config &conf, const T *data, uchar *cmpData, size_t cmpCap) {
+    if constexpr (is_half<T>::value) {
+        // the values are stored as 16 bits, the decoders need to know their format
+        conf.dataType = T::data_type;
+    }
+    if (conf.errorBoundMode == EB_RATIO || conf.errorBoundMode == EB_BITRATE) {
+        return SZ_compress_ratio<T, N>(
+            conf, data, [&](Config &absConf) { return SZ_compress_impl<T, N>(absConf, data, cmpData, cmpCap); });
+    }
 #ifndef _OPENMP
-    conf.openmp = false;
+    // without OpenMP, multi-chunk compression runs only on an executor provided by the caller
+    conf.openmp = conf.openmp && concepts::ExecutorInterface::current() != nullptr;
 #endif
+    SZ_compress_time_budget<T, N>(conf, data);
     if (conf.openmp) {
         // dataCopy for openMP is handled by each thread
         return SZ_compress_OMP<T, N>(conf, data, cmpData, cmpCap);
+    } else if (!SZ_compress_overwrites_input<T>(conf)) {
+        // the selected pipeline only reads the input, so the copy can be skipped
+        return SZ_compress_dispatcher<T, N>(conf, const_cast<T *>(data), cmpData, cmpCap);
     } else {
         std::vector<T> dataCopy(data, data + conf.num);
         return SZ_compress_dispatcher<T, N>(conf, dataCopy.data(), cmpData, cmpCap);
     }
 }
 
+/**
+ * Same as SZ_compress_impl, except that the input is used as the working buffer and will be overwritten
+ */
 template <class T, uint N>
-void SZ_decompress_impl(Config &conf, const uchar *cmpData, size_t cmpSize, T *decData) {
+size_t SZ_compress_impl_inplace(Config &conf, T *data, uchar *cmpData, size_t cmpCap) {
+    if constexpr (is_half<T>::value) {
+        conf.dataType = T::data_type;
+    }
+    if (conf.errorBoundMode == EB_RATIO || conf.errorBoundMode == EB_BITRATE) {
+        // the search compresses several times, each from the original data
+        return SZ_compress_impl<T, N>(conf, data, cmpData, cmpCap);
+    }
+#ifndef _OPENMP
+    conf.openmp = conf.openmp && concepts::ExecutorInterface::current() != nullptr;
+#endif
+    SZ_compress_time_budget<T, N>(conf, data);
+    if (conf.openmp) {
+        return SZ_compress_OMP<T, N>(conf, data, cmpData, cmpCap, true);
+    } else {
+        return SZ_compress_dispatcher<T, N>(conf, data, cmpData, cmpCap);
+    }
+}
+
+template <class T>
+size_t SZ_compress_impl_bound(Config &conf) {
 #ifndef _OPENMP
-    conf.openmp = false;
+    conf.openmp = conf.openmp && concepts::ExecutorInterface::current() != nullptr;
 #endif
     if (conf.openmp) {
-        SZ_decompress_OMP<T, N>(conf, cmpData, cmpSize, decData);
+        return SZ_compress_OMP_bound<T>(conf);
     } else {
+        return SZ_compress_dispatcher_bound<T>(conf.num);
+    }
+}
+
+/**
+ * Compress behind the header of conf, then write the header once conf is final (error bound, tuned settings).
+ * The data is compressed headerCap bytes into cmpData and moved only if the header turns out to have another size.
+ * @param compress compresses with its Config into (dst, dstCap) and returns the size, 0 if it does not fit
+ * @return size of the header and the data, 0 if they do not fit in cmpCap
+ */
+template <class Compress>
+size_t SZ_compress_framed(Config &conf, uchar *cmpData, size_t cmpCap, size_t headerCap, Compress compress) {
+    if (cmpCap <= headerCap) {
+        return 0;
+    }
+    size_t dstLen = compress(conf, cmpData + headerCap, cmpCap - headerCap);
+    if (dstLen == 0) {
+        return 0;
+    }
+    size_t headerSize = conf.saved_size();
+    if (headerSize + dstLen > cmpCap) {
+        return 0;
+    }
+    if (headerSize != headerCap) {
+        memmove(cmpData + headerSize, cmpData + headerCap, dstLen);
+    }
+    auto pos = cmpData;
+    conf.save(pos);
+    return headerSize + dstLen;
+}
+
+/**
+ * Convert the error bound of conf to an absolute error bound. The EB_RATIO and EB_BITRATE modes are only estimated
+ * on a sample, without the correction of SZ_compress_ratio.
+ */
+template <class T>
+void SZ_resolve_error_bound(Config &conf, const T *data) {
+    if (conf.errorBoundMode == EB_RATIO || conf.errorBoundMode == EB_BITRATE) {
+        if (conf.N == 1) {
+            calAbsErrorBoundFromRatio<T, 1>(conf, data);
+        } else if (conf.N == 2) {
+            calAbsErrorBoundFromRatio<T, 2>(conf, data);
+        } else if (conf.N == 3) {
+            calAbsErrorBoundFromRatio<T, 3>(conf, data);
+        } else if (conf.N == 4) {
+            calAbsErrorBoundFromRatio<T, 4>(conf, data);
+        }
+    }
+    calAbsErrorBound(conf, data);
+}
+
+/**
+ * Resolve the time budget of conf (see SZ_fit_time_budget)
+ * @param concurrency number of threads the data is compressed with
+ */
+template <class T>
+void SZ_resolve_time_budget(Config &conf, const T *data, int concurrency) {
+    if (conf.timeBudget <= 0 && conf.minThroughput <= 0) {
+        return;
+    }
+    if (conf.N == 1) {
+        SZ_fit_time_budget<T, 1>(conf, data, concurrency);
+    } else if (conf.N == 2) {
+        SZ_fit_time_budget<T, 2>(conf, data, concurrency);
+    } else if (conf.N == 3) {
+        SZ_fit_time_budget<T, 3>(conf, data, concurrency);
+    } else if (conf.N == 4) {
+        SZ_fit_time_budget<T, 4>(conf, data, concurrency);
+    }
+}
+
+/**
+ * decompress data compressed as T into values of Out
+ * The pipelines reconstruct values from their neighbors in T, so a conversion needs values of T for a whole chunk: the
+ * chunks of a container are converted one at a time, a single stream is decoded in place when Out is at least as
+ * wide as T, and into a temporary array otherwise.
+ * @param strides strides of decData in elements (see copy_box_strided), or nullptr if it is dense; the values are
+ * scattered the same way, per chunk or from a temporary array
+ */
+template <class T, uint N, class Out = T>
+void SZ_decompress_impl(Config &conf, const uchar *cmpData, size_t cmpSize, Out *decData,
+                        const std::vector<size_t> *strides = nullptr) {
+    // multi-chunk data can be decoded without OpenMP as well, one chunk after another
+    if (conf.openmp) {
+        SZ_decompress_OMP<T, N>(conf, cmpData, cmpSize, decData, strides);
+    } else if (strides != nullptr) {
+        std::vector<T> buffer(conf.num);
+        SZ_decompress_dispatcher<T, N>(conf, cmpData, cmpSize, buffer.data());
+        copy_box_strided(decData, *strides, buffer.data(), std::vector<size_t>(N, 0), conf.dims, false);
+    } else if constexpr (std::is_same<T, Out>::value) {
         SZ_decompress_dispatcher<T, N>(conf, cmpData, cmpSize, decData);
+    } else if constexpr (sizeof(Out) >= sizeof(T)) {
+        // the values of T fill the front of the array, widened from the back, each before it is overwritten
+        auto buffer = reinterpret_cast<T *>(decData);
+        SZ_decompress_dispatcher<T, N>(conf, cmpData, cmpSize, buffer);
+        for (size_t i = conf.num; i-- > 0;) {
+            T value;
+            memcpy(&value, reinterpret_cast<const char *>(decData) + i * sizeof(T), sizeof(T));
+            decData[i] = static_cast<Out>(value);
+        }
+    } else {
+        std::vector<T> buffer(conf.num);
+        SZ_decompress_dispatcher<T, N>(conf, cmpData, cmpSize, buffer.data());
+        std::copy(buffer.begin(), buffer.end(), decData);
     }
 }
 }  // namespace SZ3
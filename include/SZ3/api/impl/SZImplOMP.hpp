@@ -2,152 +2,257 @@
 #define SZ3_IMPL_SZDISPATCHER_OMP_HPP
 
 #include "SZ3/api/impl/SZDispatcher.hpp"
+#include "SZ3/executor/Executor_omp.hpp"
+#include "SZ3/utils/Container.hpp"
 #include <cmath>
 #include <memory>
 
+namespace SZ3 {
+/**
+ * Compress one chunk: the settings of the chunk that differ from base (see Config::save_delta) followed by the output of
+ * SZ_compress_dispatcher.
+ * The dimension of a chunk may be lower than the dimension of the whole array (dimensions of size 1 are dropped).
+ * @param base Config of the chunk derived from the Config of the whole array (see sub_config), as the decoder derives it
+ * @return payload size, or 0 if it does not fit in cmpCap
+ */
+template <class T>
+size_t SZ_compress_OMP_chunk(Config &conf, const Config &base, T *data, uchar *cmpData, size_t cmpCap) {
+    if (cmpCap <= conf.size_est()) {
+        return 0;
+    }
+    auto dst = cmpData + conf.size_est();
+    auto dstCap = cmpCap - conf.size_est();
+    size_t dstLen = 0;
+    if (conf.N == 1) {
+        dstLen = SZ_compress_dispatcher<T, 1>(conf, data, dst, dstCap);
+    } else if (conf.N == 2) {
+        dstLen = SZ_compress_dispatcher<T, 2>(conf, data, dst, dstCap);
+    } else if (conf.N == 3) {
+        dstLen = SZ_compress_dispatcher<T, 3>(conf, data, dst, dstCap);
+    } else if (conf.N == 4) {
+        dstLen = SZ_compress_dispatcher<T, 4>(conf, data, dst, dstCap);
+    }
+    if (dstLen == 0) {
+        return 0;
+    }
+    // the Config is known after compression (error bound, tuned settings), move the data right behind it
+    auto pos = cmpData;
+    conf.save_delta(pos, base);
+    memmove(pos, dst, dstLen);
+    return pos - cmpData + dstLen;
+}
 
-#ifdef _OPENMP
+/**
+ * Decompress one chunk produced by SZ_compress_OMP_chunk into a dense buffer of the chunk shape
+ * @param base as given to SZ_compress_OMP_chunk, or nullptr for chunks of earlier versions, which start with a full
+ * Config
+ */
+template <class T>
+void SZ_decompress_OMP_chunk(Config &conf, const Config *base, const uchar *cmpData, size_t cmpSize, T *decData) {
+    auto pos = cmpData;
+    if (base != nullptr) {
+        conf.load_delta(pos, *base);
+    } else {
+        conf.load(pos);
+    }
+    size_t len = cmpSize - (pos - cmpData);
+    if (conf.N == 1) {
+        SZ_decompress_dispatcher<T, 1>(conf, pos, len, decData);
+    } else if (conf.N == 2) {
+        SZ_decompress_dispatcher<T, 2>(conf, pos, len, decData);
+    } else if (conf.N == 3) {
+        SZ_decompress_dispatcher<T, 3>(conf, pos, len, decData);
+    } else if (conf.N == 4) {
+        SZ_decompress_dispatcher<T, 4>(conf, pos, len, decData);
+    }
+}
 
-#include <omp.h>
+/**
+ * Decompress chunk i of a container
+ * @tparam T type the data was compressed as
+ * @param payloads first payload byte, right after the container header
+ * @param decData the whole array, or a dense buffer of the chunk shape if dense is true; the values are converted to
+ * Out as the chunk is copied in
+ * @param strides strides of the whole array in elements (see copy_box_strided), or nullptr if it is dense
+ * @return false if the checksum of the chunk does not match
+ */
+template <class T, class Out = T>
+bool SZ_decompress_container_chunk(const Config &conf, const Container &container, const uchar *payloads, size_t i,
+                                   Out *decData, bool dense = false, const std::vector<size_t> *strides = nullptr) {
+    auto payload = payloads + container[i].offset;
+    if (adler32(payload, container[i].size) != container[i].checksum) {
+        return false;
+    }
+    std::vector<size_t> origin, extent;
+    container.box(i, origin, extent);
+    Config chunkConf = conf;
+    Config base = sub_config(conf, extent.begin(), extent.end());
+    auto basePtr = container.delta_headers() ? &base : nullptr;
+    if (std::is_same<T, Out>::value && strides == nullptr && (dense || box_is_contiguous(conf.dims, extent))) {
+        SZ_decompress_OMP_chunk(chunkConf, basePtr, payload, container[i].size,
+                                reinterpret_cast<T *>(dense ? decData : decData + box_offset(conf.dims, origin)));
+    } else {
+        std::vector<T> buffer(
+            std::accumulate(extent.begin(), extent.end(), static_cast<size_t>(1), std::multiplies<size_t>()));
+        SZ_decompress_OMP_chunk(chunkConf, basePtr, payload, container[i].size, buffer.data());
+        if (dense) {
+            std::copy(buffer.begin(), buffer.end(), decData);
+        } else if (strides != nullptr) {
+            copy_box_strided(decData, *strides, buffer.data(), origin, extent, false);
+        } else {
+            copy_box(decData, conf.dims, buffer.data(), origin, extent, false);
+        }
+    }
+    return true;
+}
 
-#endif
-namespace SZ3 {
-template <class T, uint N>
-size_t SZ_compress_OMP(Config &conf, const T *data, uchar *cmpData, size_t cmpCap) {
-#ifdef _OPENMP
-    unsigned char *buffer_pos = cmpData;
+/**
+ * executor for the chunks: the one bound to the current thread, otherwise fallback
+ */
+inline concepts::ExecutorInterface &SZ_executor(concepts::ExecutorInterface &fallback) {
+    auto executor = concepts::ExecutorInterface::current();
+    return executor ? *executor : fallback;
+}
 
-    assert(N == conf.N);
+// number of chunks per thread, so that dynamic scheduling can balance chunks of different cost
+constexpr size_t SZ_OMP_CHUNKS_PER_THREAD = 4;
+// smaller chunks lose too much compression ratio to the per-chunk headers and boundaries
+constexpr size_t SZ_OMP_MIN_CHUNK_SIZE = 1 << 18;
 
-    std::vector<uchar *> compressed_t;
-    std::vector<size_t> cmp_size_t, cmp_start_t;
-    std::vector<T> min_t, max_t;
-    std::vector<Config> conf_t;
-    //    Timer timer(true);
-    int nThreads = 1;
-    double eb;
-#pragma omp parallel
-#pragma omp single
-    { nThreads = omp_get_num_threads(); }
-    if (conf.dims[0] < nThreads) {
-        nThreads = conf.dims[0];
-        omp_set_num_threads(nThreads);
+/**
+ * chunk shape used by SZ_compress_OMP
+ * The array is split into about SZ_OMP_CHUNKS_PER_THREAD chunks per thread (fewer for small arrays), starting from the
+ * slowest dimension and moving on to the next one when a dimension is too short (e.g., 4x2048x2048 is split along
+ * dims[1] as well), so all threads stay busy regardless of the shape.
+ * @param concurrency number of threads of the executor
+ */
+inline std::vector<size_t> SZ_compress_OMP_chunk_dims(const Config &conf, int concurrency) {
+    auto chunkDims = conf.dims;
+    // a single thread gains nothing from balancing and only loses compression ratio
+    size_t nChunks = concurrency > 1 ? std::min<size_t>(concurrency * SZ_OMP_CHUNKS_PER_THREAD,
+                                                        std::max<size_t>(1, conf.num / SZ_OMP_MIN_CHUNK_SIZE))
+                                     : 1;
+    for (size_t d = 0; d < conf.dims.size() && nChunks > 1; d++) {
+        size_t parts = std::min(conf.dims[d], nChunks);
+        chunkDims[d] = (conf.dims[d] + parts - 1) / parts;
+        parts = (conf.dims[d] + chunkDims[d] - 1) / chunkDims[d];
+        nChunks = (nChunks + parts - 1) / parts;
     }
-    //        printf("OpenMP threads = %d\n", nThreads);
-    compressed_t.resize(nThreads);
-    cmp_size_t.resize(nThreads + 1);
-    cmp_start_t.resize(nThreads + 1);
-    conf_t.resize(nThreads);
-    min_t.resize(nThreads);
-    max_t.resize(nThreads);
-#pragma omp parallel
-    {
-        int tid = omp_get_thread_num();
-
-        auto dims_t = conf.dims;
-        int lo = tid * conf.dims[0] / nThreads;
-        int hi = (tid + 1) * conf.dims[0] / nThreads;
-        dims_t[0] = hi - lo;
-        auto it = dims_t.begin();
-        size_t num_t_base = std::accumulate(++it, dims_t.end(), (size_t)1, std::multiplies<size_t>());
-        size_t num_t = dims_t[0] * num_t_base;
-
-        //        T *data_t = data + lo * num_t_base;
-        std::vector<T> data_t(data + lo * num_t_base, data + lo * num_t_base + num_t);
-        if (conf.errorBoundMode != EB_ABS) {
-            auto minmax = std::minmax_element(data_t.begin(), data_t.end());
-            min_t[tid] = *minmax.first;
-            max_t[tid] = *minmax.second;
-#pragma omp barrier
-#pragma omp single
-            {
-                T range = *std::max_element(max_t.begin(), max_t.end()) - *std::min_element(min_t.begin(), min_t.end());
-                calAbsErrorBound<T>(conf, data, range);
-                //                timer.stop("OMP init");
-                //                timer.start();
-            }
-        }
+    return chunkDims;
+}
 
-        conf_t[tid] = conf;
-        conf_t[tid].setDims(dims_t.begin(), dims_t.end());
-        cmp_size_t[tid] = data_t.size() * sizeof(T);
-        compressed_t[tid] = (uchar *)malloc(cmp_size_t[tid]);
-        SZ_compress_dispatcher<T, N>(conf_t[tid], data_t.data(), compressed_t[tid], cmp_size_t[tid]);
-
-#pragma omp barrier
-#pragma omp single
-        {
-            //            timer.stop("OMP compression");
-            //            timer.start();
-            cmp_start_t[0] = 0;
-            for (int i = 1; i <= nThreads; i++) {
-                cmp_start_t[i] = cmp_start_t[i - 1] + cmp_size_t[i - 1];
-            }
-            size_t bufferSize = sizeof(int) + (nThreads + 1) * Config::size_est() + cmp_start_t[nThreads];
-            //                buffer = new uchar[bufferSize];
-            //                buffer_pos = buffer;
-            write(nThreads, buffer_pos);
-            for (int i = 0; i < nThreads; i++) {
-                conf_t[i].save(buffer_pos);
-            }
-            write(cmp_size_t.data(), nThreads, buffer_pos);
-        }
+/**
+ * Compress the data as a container of independently compressed chunks (see Container).
+ * Chunks run on the executor bound to the current thread, or on OpenMP with conf.nThreads threads; the number of
+ * threads in the caller's OpenMP setting is not changed.
+ * @param inplace if true, data is owned by the caller for scratch use and contiguous chunks are compressed directly
+ */
+template <class T, uint N>
+size_t SZ_compress_OMP(Config &conf, const T *data, uchar *cmpData, size_t cmpCap, bool inplace = false) {
+    assert(N == conf.N);
+    Executor_omp fallback(conf.nThreads);
+    auto &executor = SZ_executor(fallback);
 
-        memcpy(buffer_pos + cmp_start_t[tid], compressed_t[tid], cmp_size_t[tid]);
-        free(compressed_t[tid]);
+    {
+        // resolve the error bound on the whole array, so that all chunks share it; the range pass runs on the executor
+        BindScope<concepts::ExecutorInterface> executorScope(executor);
+        if (conf.errorBoundMode == EB_RATIO || conf.errorBoundMode == EB_BITRATE) {
+            calAbsErrorBoundFromRatio<T, N>(conf, data);
+        }
+        calAbsErrorBound<T>(conf, data);
     }
 
-    return buffer_pos - cmpData + cmp_start_t[nThreads];
-    //    timer.stop("OMP memcpy");
+    Container container(conf.dims, SZ_compress_OMP_chunk_dims(conf, executor.concurrency()));
+    size_t nChunks = container.size();
+    std::vector<std::unique_ptr<uchar[]>> payloads(nChunks);
+    auto dictionary = ZstdDictionary::current();
 
-#else
-    std::vector<T> dataCopy(data, data + conf.num);
-    return SZ_compress_dispatcher<T, N>(conf, dataCopy.data(), cmpData, cmpCap);
-#endif
-}
+    executor.parallel_for(nChunks, [&](size_t i) {
+        BindScope<ZstdDictionary> dictionaryScope(dictionary);
+        std::vector<size_t> origin, extent;
+        container.box(i, origin, extent);
+        Config chunkConf = sub_config(conf, extent.begin(), extent.end());
 
-template <class T, uint N>
-void SZ_decompress_OMP(Config &conf, const uchar *cmpData, size_t cmpSize, T *decData) {
-#ifdef _OPENMP
+        std::vector<T> dataCopy;
+        T *chunkData;
+        if (box_is_contiguous(conf.dims, extent) && (inplace || !SZ_compress_overwrites_input<T>(chunkConf))) {
+            chunkData = const_cast<T *>(data) + box_offset(conf.dims, origin);
+        } else {
+            dataCopy.resize(chunkConf.num);
+            copy_box(const_cast<T *>(data), conf.dims, dataCopy.data(), origin, extent, true);
+            chunkData = dataCopy.data();
+        }
 
-    auto cmpr_data_pos = cmpData;
-    int nThreads = 1;
-    read(nThreads, cmpr_data_pos);
-    omp_set_num_threads(nThreads);
-    //    printf("OpenMP threads = %d\n", nThreads);
-
-    std::vector<Config> conf_t(nThreads);
-    for (int i = 0; i < nThreads; i++) {
-        conf_t[i].load(cmpr_data_pos);
+        Config base = chunkConf;
+        size_t chunkCap = Config::size_est() + SZ_compress_dispatcher_bound<T>(chunkConf.num);
+        payloads[i].reset(new uchar[chunkCap]);
+        container[i].size = SZ_compress_OMP_chunk(chunkConf, base, chunkData, payloads[i].get(), chunkCap);
+        container[i].checksum = adler32(payloads[i].get(), container[i].size);
+    });
+
+    uint64_t offset = 0;
+    for (size_t i = 0; i < nChunks; i++) {
+        if (container[i].size == 0) {
+            return 0;
+        }
+        container[i].offset = offset;
+        offset += container[i].size;
+    }
+    if (container.total_size() > cmpCap) {
+        return 0;
     }
 
-    std::vector<size_t> cmp_start_t, cmp_size_t;
-    cmp_size_t.resize(nThreads);
-    read(cmp_size_t.data(), nThreads, cmpr_data_pos);
-    auto cmpr_data_p = cmpr_data_pos;
+    auto payload_pos = cmpData;
+    container.save(payload_pos);
+    executor.parallel_for(nChunks, [&](size_t i) {
+        memcpy(payload_pos + container[i].offset, payloads[i].get(), container[i].size);
+        payloads[i].reset();
+    });
+    return container.total_size();
+}
 
-    cmp_start_t.resize(nThreads + 1);
-    cmp_start_t[0] = 0;
-    for (int i = 1; i <= nThreads; i++) {
-        cmp_start_t[i] = cmp_start_t[i - 1] + cmp_size_t[i - 1];
+/**
+ * upper bound of the output size of SZ_compress_OMP
+ */
+template <class T>
+size_t SZ_compress_OMP_bound(const Config &conf) {
+    Executor_omp fallback(conf.nThreads);
+    Container container(conf.dims, SZ_compress_OMP_chunk_dims(conf, SZ_executor(fallback).concurrency()));
+    size_t bound = container.header_bound();
+    std::vector<size_t> origin, extent;
+    for (size_t i = 0; i < container.size(); i++) {
+        container.box(i, origin, extent);
+        size_t num = std::accumulate(extent.begin(), extent.end(), static_cast<size_t>(1), std::multiplies<size_t>());
+        // the settings of a chunk take no more than a whole header of its dims
+        bound += Config::max_saved_size(extent) + SZ_compress_dispatcher_bound<T>(num);
     }
+    return bound;
+}
 
-#pragma omp parallel
-    {
-        int tid = omp_get_thread_num();
-        auto dims_t = conf.dims;
-        int lo = tid * conf.dims[0] / nThreads;
-        int hi = (tid + 1) * conf.dims[0] / nThreads;
-        dims_t[0] = hi - lo;
-        auto it = dims_t.begin();
-        size_t num_t_base = std::accumulate(++it, dims_t.end(), (size_t)1, std::multiplies<size_t>());
-
-        SZ_decompress_dispatcher<T, N>(conf_t[tid], cmpr_data_p + cmp_start_t[tid], cmp_size_t[tid],
-                                       decData + lo * num_t_base);
+/**
+ * Decompress a container produced by SZ_compress_OMP.
+ * Chunks are independent, so they are decoded by the executor bound to the current thread, or by OpenMP with
+ * conf.nThreads threads (serially without OpenMP), regardless of the number of threads used for compression.
+ * @param strides strides of decData in elements (see copy_box_strided), or nullptr if it is dense
+ */
+template <class T, uint N, class Out = T>
+void SZ_decompress_OMP(Config &conf, const uchar *cmpData, size_t cmpSize, Out *decData,
+                       const std::vector<size_t> *strides = nullptr) {
+    auto cmpr_data_pos = cmpData;
+    Container container;
+    container.load(cmpr_data_pos, conf.dims);
+    if (container.total_size() > cmpSize) {
+        throw std::invalid_argument("truncated SZ3 multi-chunk stream");
     }
-#else
-    SZ_decompress_dispatcher<T, N>(conf, cmpData, cmpSize, decData);
-#endif
+
+    Executor_omp fallback(conf.nThreads);
+    auto dictionary = ZstdDictionary::current();
+    SZ_executor(fallback).parallel_for(container.size(), [&](size_t i) {
+        BindScope<ZstdDictionary> dictionaryScope(dictionary);
+        if (!SZ_decompress_container_chunk<T>(conf, container, cmpr_data_pos, i, decData, false, strides)) {
+            throw std::runtime_error("checksum mismatch, the compressed data is corrupted");
+        }
+    });
 }
 }  // namespace SZ3
 
@@ -0,0 +1,149 @@
+#ifndef SZ3_IMPL_SZ_TIME_BUDGET_HPP
+#define SZ3_IMPL_SZ_TIME_BUDGET_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "SZ3/api/impl/SZDispatcher.hpp"
+#include "SZ3/utils/Container.hpp"
+#include "SZ3/utils/Extraction.hpp"
+#include "SZ3/utils/Timer.hpp"
+#include "SZ3/utils/TuningCache.hpp"
+
+namespace SZ3 {
+// number of pipeline variants, see SZ_budget_variant
+constexpr int SZ_BUDGET_VARIANTS = 6;
+
+/**
+ * Switch conf to pipeline variant v. The variants go from the configured pipeline to cheaper ones, each giving up
+ * compression ratio for speed:
+ * 0: as configured
+ * 1: ALGO_INTERP_LORENZO without tuning (ALGO_INTERP with the configured interpolation)
+ * 2: ALGO_INTERP with linear interpolation
+ * 3: ALGO_LORENZO_REG with first-order lorenzo only
+ * 4: ALGO_NOPRED
+ * 5: ALGO_NOPRED without zstd
+ * @return false if the variant does not apply to conf, i.e., it is not cheaper than the configured pipeline
+ */
+inline bool SZ_budget_variant(Config &conf, int v) {
+    bool interp = conf.cmprAlgo == ALGO_INTERP_LORENZO || conf.cmprAlgo == ALGO_INTERP;
+    bool lorenzoOnly = conf.cmprAlgo == ALGO_LORENZO_REG && !conf.lorenzo2 && !conf.regression && !conf.regression2;
+    switch (v) {
+        case 0:
+            return true;
+        case 1:
+            if (conf.cmprAlgo != ALGO_INTERP_LORENZO) {
+                return false;
+            }
+            conf.cmprAlgo = ALGO_INTERP;
+            return true;
+        case 2:
+            if (!interp || (conf.cmprAlgo == ALGO_INTERP && conf.interpAlgo == INTERP_ALGO_LINEAR)) {
+                return false;
+            }
+            conf.cmprAlgo = ALGO_INTERP;
+            conf.interpAlgo = INTERP_ALGO_LINEAR;
+            return true;
+        case 3:
+            if (lorenzoOnly || conf.cmprAlgo == ALGO_NOPRED) {
+                return false;
+            }
+            conf.cmprAlgo = ALGO_LORENZO_REG;
+            conf.lorenzo = true;
+            conf.lorenzo2 = false;
+            conf.regression = false;
+            conf.regression2 = false;
+            return true;
+        case 4:
+            if (conf.cmprAlgo == ALGO_NOPRED) {
+                return false;
+            }
+            conf.cmprAlgo = ALGO_NOPRED;
+            return true;
+        case 5:
+            if (conf.cmprAlgo == ALGO_NOPRED && conf.lossless == 0) {
+                return false;
+            }
+            conf.cmprAlgo = ALGO_NOPRED;
+            conf.lossless = 0;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Resolve the time budget of conf (conf.timeBudget, conf.minThroughput): choose the first pipeline variant (see
+ * SZ_budget_variant) whose compression time fits in the budget left after choosing. The time of each variant is
+ * predicted from a trial compression of a sample of the data; if none fits, the fastest one is chosen.
+ * The chosen variant is left in conf with conf.budgetVariant and conf.predictedTime, and the budget is reset to 0.
+ * @param concurrency number of threads the data is compressed with
+ */
+template <class T, uint N>
+void SZ_fit_time_budget(Config &conf, const T *data, int concurrency) {
+    Timer timer(true);
+    double budget = conf.timeBudget > 0 ? conf.timeBudget : INFINITY;
+    if (conf.minThroughput > 0) {
+        budget = std::min(budget, conf.num * sizeof(T) / (conf.minThroughput * 1e9));
+    }
+    conf.timeBudget = 0;
+    conf.minThroughput = 0;
+    conf.budgetVariant = 0;
+    conf.predictedTime = 0;
+    if (!std::isfinite(budget)) {
+        return;
+    }
+    // the trials need the absolute error bound, conf keeps its error bound mode. conf may be the caller's Config (see
+    // SZ_plan_time_budget) and be reused for other data, so the value range stays in resolved as well.
+    Config resolved(conf);
+    if (resolved.errorBoundMode == EB_RATIO || resolved.errorBoundMode == EB_BITRATE) {
+        calAbsErrorBoundFromRatio<T, N>(resolved, data);
+    }
+    calAbsErrorBound(resolved, data);
+    if (resolved.absErrorBound == 0 || resolved.cmprAlgo == ALGO_LOSSLESS) {
+        // lossless compression has no cheaper variant
+        return;
+    }
+
+    // large enough to time the pipeline rather than its fixed costs
+    double fraction = std::min(0.5, std::max(1.0 / 64, 131072.0 / conf.num));
+    std::vector<size_t> sample_dims;
+    std::vector<T> sample = sampling_box<T, N>(data, conf.dims, sample_dims, fraction);
+    Config trial = sub_config(resolved, sample_dims.begin(), sample_dims.end());
+    trial.openmp = false;
+    std::vector<T> trialData(trial.num);
+    std::vector<uchar> buffer(SZ_compress_dispatcher_bound<T>(trial.num));
+    // the trials are not tuned for the data, keep them out of the caller's cache
+    TuningCache trialCache;
+    BindScope<TuningCache> cacheScope(trialCache);
+    double scale = static_cast<double>(conf.num) / trial.num / std::max(concurrency, 1);
+
+    int chosen = 0;
+    double chosenTime = INFINITY;
+    for (int v = 0; v < SZ_BUDGET_VARIANTS; v++) {
+        Config c = trial;
+        if (!SZ_budget_variant(c, v)) {
+            continue;
+        }
+        std::copy(sample.begin(), sample.end(), trialData.begin());
+        Timer trialTimer(true);
+        SZ_compress_dispatcher<T, N>(c, trialData.data(), buffer.data(), buffer.size());
+        double predicted = trialTimer.stop() * scale;
+        if (predicted <= budget - timer.stop()) {
+            chosen = v;
+            chosenTime = predicted;
+            break;
+        }
+        if (predicted < chosenTime) {
+            chosen = v;
+            chosenTime = predicted;
+        }
+    }
+    SZ_budget_variant(conf, chosen);
+    conf.budgetVariant = chosen;
+    conf.predictedTime = chosenTime;
+}
+}  // namespace SZ3
+
+#endif
@@ -0,0 +1,285 @@
+#ifndef SZ3_STREAM_HPP
+#define SZ3_STREAM_HPP
+
+#include <functional>
+
+#include "SZ3/api/sz.hpp"
+#include "SZ3/lossless/Lossless_zstd.hpp"
+#include "SZ3/utils/Workspace.hpp"
+
+#define SZ3_STREAM_MAGIC_NUMBER 0xF342F320
+
+namespace SZ3 {
+/**
+ * Streaming (out-of-core) compression for arrays larger than memory.
+ * The array is pushed as slabs along dims[0]. Rows are buffered until a segment (segmentRows rows) is complete, then
+ * the segment is compressed independently and written to the sink, so only one segment is kept in memory.
+ *
+ * Stream layout: magic, Config of the whole array, segmentRows, then for each segment its compressed size (uint64_t)
+ * followed by an SZ_compress stream; a compressed size of 0 ends the stream.
+ *
+ * Segments are compressed independently, so the error bound must not depend on the whole array: use EB_ABS.
+
+ example:
+ SZ3::StreamCompressor<float> stream([&](const char *bytes, size_t len) { fwrite(bytes, 1, len, f); });
+ stream.begin(conf);
+ while (...) stream.push_slab(slab, rows);
+ stream.finish();
+ */
+template <class T>
+class StreamCompressor {
+   public:
+    using Sink = std::function<void(const char *bytes, size_t len)>;
+
+    explicit StreamCompressor(Sink sink) : sink(std::move(sink)) {}
+
+    /**
+     * start a new stream
+     * @param config configuration of the whole array
+     * @param segmentRows number of rows (along dims[0]) in each segment, 0 for about 16M elements per segment
+     */
+    void begin(const Config &config, size_t segmentRows = 0) {
+        if (config.errorBoundMode != EB_ABS) {
+            throw std::invalid_argument("streaming compression only supports EB_ABS error bound mode");
+        }
+        conf = config;
+        rowSize = conf.num / conf.dims[0];
+        segRows = segmentRows ? segmentRows : std::max<size_t>(1, (static_cast<size_t>(1) << 24) / rowSize);
+        segRows = std::min(segRows, conf.dims[0]);
+        window.resize(segRows * rowSize);
+        windowRows = 0;
+        pushedRows = 0;
+
+        std::vector<uchar> header(sizeof(uint32_t) + Config::size_est() + sizeof(uint64_t));
+        auto header_pos = header.data();
+        write(static_cast<uint32_t>(SZ3_STREAM_MAGIC_NUMBER), header_pos);
+        conf.save(header_pos);
+        write(static_cast<uint64_t>(segRows), header_pos);
+        sink(reinterpret_cast<const char *>(header.data()), header_pos - header.data());
+    }
+
+    /**
+     * append rows to the stream
+     * @param slab rows * (dims[1] * ... * dims[N-1]) elements
+     * @param rows number of rows along dims[0]
+     */
+    void push_slab(const T *slab, size_t rows) {
+        if (pushedRows + rows > conf.dims[0]) {
+            throw std::invalid_argument("more rows pushed than dims[0]");
+        }
+        pushedRows += rows;
+        while (rows > 0) {
+            if (windowRows == 0 && rows >= segRows) {
+                // a complete segment in the caller's buffer, no need to copy it into the window
+                compress_segment(slab, segRows);
+                slab += segRows * rowSize;
+                rows -= segRows;
+                continue;
+            }
+            size_t n = std::min(rows, segRows - windowRows);
+            std::copy_n(slab, n * rowSize, window.data() + windowRows * rowSize);
+            windowRows += n;
+            slab += n * rowSize;
+            rows -= n;
+            if (windowRows == segRows) {
+                compress_segment(window.data(), windowRows);
+                windowRows = 0;
+            }
+        }
+    }
+
+    /**
+     * append a segment that was compressed elsewhere (e.g., by another thread) with
+     * SZ_compress(segment_config(rows), ...). Segments must be appended in order and not mixed with buffered rows.
+     * @param rows number of rows in the segment, segment_rows() except for the last segment
+     */
+    void push_compressed(size_t rows, const char *cmpData, size_t cmpSize) {
+        if (windowRows != 0 || rows > segRows || pushedRows + rows > conf.dims[0]) {
+            throw std::invalid_argument("compressed segment does not match the stream");
+        }
+        pushedRows += rows;
+        write_size(cmpSize);
+        sink(cmpData, cmpSize);
+    }
+
+    /**
+     * number of rows (along dims[0]) in each segment
+     */
+    size_t segment_rows() const { return segRows; }
+
+    /**
+     * configuration for compressing a segment of the given number of rows
+     */
+    Config segment_config(size_t rows) const {
+        auto dims = conf.dims;
+        dims[0] = rows;
+        return sub_config(conf, dims.begin(), dims.end());
+    }
+
+    /**
+     * flush the remaining rows and end the stream
+     */
+    void finish() {
+        if (windowRows > 0) {
+            compress_segment(window.data(), windowRows);
+            windowRows = 0;
+        }
+        if (pushedRows != conf.dims[0]) {
+            throw std::invalid_argument("fewer rows pushed than dims[0]");
+        }
+        write_size(0);
+    }
+
+   private:
+    void compress_segment(const T *data, size_t rows) {
+        BindScope<Workspace> wsScope(workspace);
+        BindScope<ZstdContext> zstdScope(zstd);
+
+        Config segConf = segment_config(rows);
+
+        cmpBuffer.resize(SZ_compress_bound<T>(segConf));
+        size_t cmpSize;
+        if (data == window.data()) {
+            // the window is refilled for the next segment anyway, use it as the working buffer
+            cmpSize = SZ_compress_inplace(segConf, window.data(), cmpBuffer.data(), cmpBuffer.size());
+        } else {
+            cmpSize = SZ_compress(segConf, data, cmpBuffer.data(), cmpBuffer.size());
+        }
+        if (cmpSize == 0) {
+            // a size of 0 marks the end of the stream
+            throw std::runtime_error("compression of a segment failed");
+        }
+        write_size(cmpSize);
+        sink(cmpBuffer.data(), cmpSize);
+    }
+
+    void write_size(uint64_t size) { sink(reinterpret_cast<const char *>(&size), sizeof(size)); }
+
+    Sink sink;
+    Config conf;
+    size_t rowSize = 0, segRows = 0, windowRows = 0, pushedRows = 0;
+    std::vector<T> window;
+    std::vector<char> cmpBuffer;
+    Workspace workspace;
+    ZstdContext zstd;
+};
+
+/**
+ * Streaming decompression for streams produced by StreamCompressor.
+ * Segments are decoded one at a time, so only one compressed segment and one decompressed segment are kept in memory.
+
+ example:
+ SZ3::StreamDecompressor<float> stream([&](char *bytes, size_t len) { return fread(bytes, 1, len, f); });
+ auto conf = stream.begin();
+ std::vector<float> rows(stream.segment_rows() * (conf.num / conf.dims[0]));
+ while (size_t n = stream.next_slab(rows.data())) { ... }
+ */
+template <class T>
+class StreamDecompressor {
+   public:
+    using Source = std::function<size_t(char *bytes, size_t len)>;
+
+    explicit StreamDecompressor(Source source) : source(std::move(source)) {}
+
+    /**
+     * read the stream header
+     * @return configuration of the whole array
+     */
+    const Config &begin() {
+        uint32_t magic;
+        read_exact(&magic, sizeof(magic));
+        if (magic != SZ3_STREAM_MAGIC_NUMBER) {
+            throw std::invalid_argument("magic number mismatch, the input is not an SZ3 stream");
+        }
+        // Config is variable-length, read the maximum and keep the unused tail for the next field. A short stream
+        // leaves zeros behind what was read, so load never runs past the buffer, but the header must end within len.
+        std::vector<uchar> header(Config::size_est() + sizeof(uint64_t));
+        size_t len = read_some(reinterpret_cast<char *>(header.data()), header.size());
+        if (len < Config::min_saved_size({}) + sizeof(uint64_t)) {
+            throw std::invalid_argument("truncated SZ3 stream header");
+        }
+        const uchar *header_pos = header.data();
+        conf.load(header_pos);
+        if (header_pos + sizeof(uint64_t) > header.data() + len) {
+            throw std::invalid_argument("truncated SZ3 stream header");
+        }
+        uint64_t rows;
+        read(rows, header_pos);
+        segRows = rows;
+        pending.assign(header_pos, static_cast<const uchar *>(header.data() + len));
+        rowSize = conf.num / conf.dims[0];
+        return conf;
+    }
+
+    /**
+     * maximum number of rows returned by next_slab()
+     */
+    size_t segment_rows() const { return segRows; }
+
+    /**
+     * decompress the next segment
+     * @param decData buffer for at least segment_rows() * (dims[1] * ... * dims[N-1]) elements
+     * @return number of rows decompressed, 0 at the end of the stream
+     */
+    size_t next_slab(T *decData) {
+        BindScope<Workspace> wsScope(workspace);
+        BindScope<ZstdContext> zstdScope(zstd);
+
+        if (!next_compressed(cmpBuffer)) {
+            return 0;
+        }
+        Config segConf;
+        SZ_decompress(segConf, cmpBuffer.data(), cmpBuffer.size(), decData);
+        return segConf.num / rowSize;
+    }
+
+    /**
+     * read the next segment without decompressing it (e.g., to decompress it on another thread with SZ_decompress)
+     * @return false at the end of the stream
+     */
+    bool next_compressed(std::vector<char> &cmpData) {
+        uint64_t cmpSize;
+        read_exact(&cmpSize, sizeof(cmpSize));
+        if (cmpSize == 0) {
+            return false;
+        }
+        cmpData.resize(cmpSize);
+        read_exact(cmpData.data(), cmpSize);
+        return true;
+    }
+
+   private:
+    // read up to len bytes from source, which may return fewer than asked before the end of the stream
+    size_t read_some(char *dst, size_t len) {
+        size_t total = 0;
+        while (total < len) {
+            size_t n = source(dst + total, len - total);
+            if (n == 0) {
+                break;
+            }
+            total += n;
+        }
+        return total;
+    }
+
+    void read_exact(void *dst, size_t len) {
+        auto dst_pos = static_cast<char *>(dst);
+        size_t n = std::min(len, pending.size());
+        std::copy_n(pending.begin(), n, dst_pos);
+        pending.erase(pending.begin(), pending.begin() + n);
+        if (n < len && read_some(dst_pos + n, len - n) != len - n) {
+            throw std::invalid_argument("truncated SZ3 stream");
+        }
+    }
+
+    Source source;
+    Config conf;
+    size_t rowSize = 0, segRows = 0;
+    std::vector<uchar> pending;
+    std::vector<char> cmpBuffer;
+    Workspace workspace;
+    ZstdContext zstd;
+};
+}  // namespace SZ3
+
+#endif
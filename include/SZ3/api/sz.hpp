@@ -3,17 +3,75 @@
 
 
 #include "SZ3/api/impl/SZImpl.hpp"
+#include "SZ3/executor/Executor.hpp"
+#include "SZ3/utils/Workspace.hpp"
 #include "SZ3/version.hpp"
 
 /**
- * API for compression
+ * Upper bound of the compressed data size
+ * A buffer of this size always fits the output of SZ_compress and SZ_compress_inplace with the same config, so several
+ * compressed fields can be packed into one pre-allocated buffer without over-provisioning. The header is counted at its
+ * largest (Config::max_saved_size) and is not padded, so any cmpCap of at least the actual compressed size is enough:
+ * the bound only matters when that size is not known yet.
+ * @tparam T source data type
+ * @param config compression configuration
+ * @param executor the executor that will be passed to SZ_compress, if any
+ * @return worst-case compressed data size (in bytes)
+ */
+template <class T>
+size_t SZ_compress_bound(const SZ3::Config &config, SZ3::concepts::ExecutorInterface *executor = nullptr) {
+    using namespace SZ3;
+    BindScope<concepts::ExecutorInterface> executorScope(executor);
+    Config conf(config);
+    if (executor != nullptr) {
+        conf.openmp = true;
+    }
+    return Config::max_saved_size(conf.dims) + SZ_compress_impl_bound<T>(conf);
+}
+
+/**
+ * Choose the pipeline for the time budget of the config (config.timeBudget or config.minThroughput) ahead of
+ * SZ_compress, which otherwise does it by itself. The chosen pipeline variant (see SZ3::SZ_budget_variant) is applied
+ * to config, config.budgetVariant and config.predictedTime report it, and the budget is reset to 0, so that compressing
+ * with config afterwards uses the chosen variant without choosing again.
  * @tparam T source data type
+ * @param config compression configuration, updated with the chosen variant
+ * @param data source data
+ * @param executor the executor that will be passed to SZ_compress, if any
+
+ example:
+ conf.timeBudget = 0.5; // seconds
+ SZ_plan_time_budget(conf, data);
+ printf("variant %d, %.2fs predicted\n", conf.budgetVariant, conf.predictedTime);
+ size_t cmpSize = SZ_compress(conf, data, cmpData, cmpCap);
+ */
+template <class T>
+void SZ_plan_time_budget(SZ3::Config &config, const T *data, SZ3::concepts::ExecutorInterface *executor = nullptr) {
+    using namespace SZ3;
+    Executor_omp fallback(config.nThreads);
+    int concurrency = 1;
+    if (executor != nullptr) {
+        concurrency = executor->concurrency();
+    } else if (config.openmp) {
+        concurrency = SZ_executor(fallback).concurrency();
+    }
+    SZ_resolve_time_budget(config, data, concurrency);
+}
+
+/**
+ * API for compression
+ * @tparam T source data type: float, double, an integer type, or SZ3::float16 / SZ3::bfloat16 for half precision data
+ (see SZ3/utils/Half.hpp), whose working copy is in float, so the caller does not convert it
  * @param config compression configuration. Please update the config with 1). data dimension and shape and 2). desired
 settings.
  * @param data source data
  * @param cmpData pre-allocated buffer for compressed data
- * @param cmpCap pre-allocated buffer size (in bytes) for compressed data
- * @return compressed data size (in bytes)
+ * @param cmpCap pre-allocated buffer size (in bytes) for compressed data. It can be smaller than the original data;
+ use SZ_compress_bound(config) to get a capacity that always fits.
+ * @param executor optional executor (e.g., Executor_threadpool) to run the compression on. If set, the data is
+ compressed as independent chunks in parallel, like with config.openmp enabled, but without OpenMP threads.
+ With config.timeBudget or config.minThroughput, cheaper pipelines are used if needed to fit (see SZ_plan_time_budget).
+ * @return compressed data size (in bytes), or 0 if the compressed data does not fit in cmpCap
 
 The compression algorithms are:
 ALGO_INTERP_LORENZO:
@@ -52,35 +110,40 @@ conf.absErrorBound = 1E-3; // absolute error bound 1e-3
 char *compressedData = SZ_compress(conf, data, outSize);
  */
 template <class T>
-size_t SZ_compress(const SZ3::Config &config, const T *data, char *cmpData, size_t cmpCap) {
+size_t SZ_compress(const SZ3::Config &config, const T *data, char *cmpData, size_t cmpCap,
+                   SZ3::concepts::ExecutorInterface *executor = nullptr) {
     using namespace SZ3;
+    BindScope<concepts::ExecutorInterface> executorScope(executor);
     Config conf(config);
-
-    if (cmpCap < conf.num * sizeof(T)) {
-        throw std::invalid_argument(
-            "cmpCap too small, remember to initialize the cmpCap with at least the same size of the original data");
+    if (executor != nullptr) {
+        conf.openmp = true;
     }
 
-    auto dst = reinterpret_cast<uchar *>(cmpData) + conf.size_est();
-    auto dstCap = cmpCap - conf.size_est();
-
-    size_t dstLen = 0;
-    if (conf.N == 1) {
-        dstLen = SZ_compress_impl<T, 1>(conf, data, dst, dstCap);
-    } else if (conf.N == 2) {
-        dstLen = SZ_compress_impl<T, 2>(conf, data, dst, dstCap);
-    } else if (conf.N == 3) {
-        dstLen = SZ_compress_impl<T, 3>(conf, data, dst, dstCap);
-    } else if (conf.N == 4) {
-        dstLen = SZ_compress_impl<T, 4>(conf, data, dst, dstCap);
-    } else {
-        printf("Data dimension higher than 4 is not supported.\n");
-        exit(0);
+    auto compress = [&](Config &c, uchar *dst, size_t dstCap) -> size_t {
+        if (c.N == 1) {
+            return SZ_compress_impl<T, 1>(c, data, dst, dstCap);
+        } else if (c.N == 2) {
+            return SZ_compress_impl<T, 2>(c, data, dst, dstCap);
+        } else if (c.N == 3) {
+            return SZ_compress_impl<T, 3>(c, data, dst, dstCap);
+        } else if (c.N == 4) {
+            return SZ_compress_impl<T, 4>(c, data, dst, dstCap);
+        } else {
+            printf("Data dimension higher than 4 is not supported.\n");
+            exit(0);
+        }
+    };
+    // the header mostly keeps the size it has before compression. If the data does not fit behind it, a header of
+    // the smallest size leaves the most room for a second try.
+    Config initial(conf);
+    size_t headerCap = conf.saved_size(), minHeaderCap = Config::min_saved_size(conf.dims);
+    auto dst = reinterpret_cast<uchar *>(cmpData);
+    size_t cmpSize = SZ_compress_framed(conf, dst, cmpCap, headerCap, compress);
+    if (cmpSize == 0 && headerCap > minHeaderCap) {
+        conf = initial;
+        cmpSize = SZ_compress_framed(conf, dst, cmpCap, minHeaderCap, compress);
     }
-
-    auto confPos = reinterpret_cast<uchar *>(cmpData);
-    conf.save(confPos);
-    return conf.size_est() + dstLen;
+    return cmpSize;
 }
 
 /**
@@ -95,54 +158,178 @@ size_t SZ_compress(const SZ3::Config &config, const T *data, char *cmpData, size
  * The only difference is this one doesn't need the pre-allocated buffer (thus remember to do 'delete []' yourself)
  */
 template <class T>
-char *SZ_compress(const SZ3::Config &config, const T *data, size_t &cmpSize) {
+char *SZ_compress(const SZ3::Config &config, const T *data, size_t &cmpSize,
+                  SZ3::concepts::ExecutorInterface *executor = nullptr) {
     using namespace SZ3;
 
-    size_t bufferLen = config.num * sizeof(T) * 1.2;
+    size_t bufferLen = SZ_compress_bound<T>(config, executor);
     auto buffer = new char[bufferLen];
-    cmpSize = SZ_compress(config, data, buffer, bufferLen);
+    cmpSize = SZ_compress(config, data, buffer, bufferLen, executor);
 
     return buffer;
 }
 
 /**
- * API for decompression
- * @tparam T decompressed data type
- * @param config configuration placeholder. It will be overwritten by the compression configuration
- * @param cmpData compressed data
- * @param cmpSize compressed data size in bytes
- * @param decData pre-allocated buffer for decompressed data
+ * API for compression without copying the input
+ * Similar with SZ_compress(SZ3::Config &conf, const T *data, char *cmpData, size_t cmpCap)
+ * The difference is the input buffer is donated by the caller and used as the working buffer, which saves one full copy
+ * of the input. The content of data is undefined after this call.
+ *
+ * @tparam T source data type
+ * @param config compression configuration
+ * @param data source data, will be overwritten
+ * @param cmpData pre-allocated buffer for compressed data
+ * @param cmpCap pre-allocated buffer size (in bytes) for compressed data
+ * @param executor optional executor to run the compression on
+ * @return compressed data size (in bytes), or 0 if the compressed data does not fit in cmpCap
+ */
+template <class T>
+size_t SZ_compress_inplace(const SZ3::Config &config, T *data, char *cmpData, size_t cmpCap,
+                           SZ3::concepts::ExecutorInterface *executor = nullptr) {
+    using namespace SZ3;
+    BindScope<concepts::ExecutorInterface> executorScope(executor);
+    Config conf(config);
+    if (executor != nullptr) {
+        conf.openmp = true;
+    }
+
+    auto compress = [&](Config &c, uchar *dst, size_t dstCap) -> size_t {
+        if (c.N == 1) {
+            return SZ_compress_impl_inplace<T, 1>(c, data, dst, dstCap);
+        } else if (c.N == 2) {
+            return SZ_compress_impl_inplace<T, 2>(c, data, dst, dstCap);
+        } else if (c.N == 3) {
+            return SZ_compress_impl_inplace<T, 3>(c, data, dst, dstCap);
+        } else if (c.N == 4) {
+            return SZ_compress_impl_inplace<T, 4>(c, data, dst, dstCap);
+        } else {
+            printf("Data dimension higher than 4 is not supported.\n");
+            exit(0);
+        }
+    };
+    // the input is gone after one try, so the data gets all the room the smallest header leaves
+    return SZ_compress_framed(conf, reinterpret_cast<uchar *>(cmpData), cmpCap, Config::min_saved_size(conf.dims),
+                              compress);
+}
+
+/**
+ * API for compression without copying the input
+ * Similar with SZ_compress_inplace(SZ3::Config &conf, T *data, char *cmpData, size_t cmpCap)
+ * The only difference is this one doesn't need the pre-allocated buffer (thus remember to do 'delete []' yourself)
+ */
+template <class T>
+char *SZ_compress_inplace(const SZ3::Config &config, T *data, size_t &cmpSize,
+                          SZ3::concepts::ExecutorInterface *executor = nullptr) {
+    using namespace SZ3;
+
+    size_t bufferLen = SZ_compress_bound<T>(config, executor);
+    auto buffer = new char[bufferLen];
+    cmpSize = SZ_compress_inplace(config, data, buffer, bufferLen, executor);
+
+    return buffer;
+}
+
+/**
+ * API for compression of a strided view, e.g., a field with ghost layers or one field of an array of structures
+ * Similar with SZ_compress(SZ3::Config &conf, const T *data, char *cmpData, size_t cmpCap)
+ * The values are gathered into the working copy of the compression, so the caller does not pack them first.
+ *
+ * @tparam T source data type
+ * @param config compression configuration, with the shape of the view
+ * @param data first value of the view
+ * @param strides distance in elements between consecutive indices of each dimension of the view, one per dimension
+ * @param cmpData pre-allocated buffer for compressed data
+ * @param cmpCap pre-allocated buffer size (in bytes) for compressed data
+ * @param executor optional executor to run the compression on
+ * @return compressed data size (in bytes), or 0 if the compressed data does not fit in cmpCap
+
+ example (the interior of a 100x200x300 field with ghost layers of width 2, and the vx field of xyz+v structures):
+ SZ3::Config conf(96, 196, 296);
+ SZ_compress_strided(conf, field + (2 * 200 + 2) * 300 + 2, {200 * 300, 300, 1}, cmpData, cmpCap);
+ SZ3::Config conf2(nx, ny);
+ SZ_compress_strided(conf2, &particles[0].vx, {ny * 6, 6}, cmpData, cmpCap);
+ */
+template <class T>
+size_t SZ_compress_strided(const SZ3::Config &config, const T *data, const std::vector<size_t> &strides, char *cmpData,
+                           size_t cmpCap, SZ3::concepts::ExecutorInterface *executor = nullptr) {
+    using namespace SZ3;
+    if (strides.size() != config.dims.size()) {
+        throw std::invalid_argument("one stride per dimension is required");
+    }
+    if (strides == dense_strides(config.dims)) {
+        return SZ_compress(config, data, cmpData, cmpCap, executor);
+    }
+    std::vector<T> dataCopy(config.num);
+    std::vector<size_t> origin(config.dims.size(), 0);
+    copy_box_strided(const_cast<T *>(data), strides, dataCopy.data(), origin, config.dims, true);
+    return SZ_compress_inplace(config, dataCopy.data(), cmpData, cmpCap, executor);
+}
+
+/**
+ * API for decompression into values of another type
+ * Same as SZ_decompress, except that the data compressed as T is written to an array of Out (e.g., double data to a
+ * float array), the values being converted as the chunks are decoded, without a decompressed array of T.
+ * @tparam T type the data was compressed as
+ * @tparam Out decompressed data type
+ * @param decData pre-allocated buffer for decompressed data, or nullptr to allocate it with new Out[]
 
  example:
  auto decData = new float[100*200*300];
  SZ3::Config conf;
- SZ_decompress(conf, cmpData, cmpSize, decData);
+ SZ_decompress_convert<double>(conf, cmpData, cmpSize, decData);
 
  */
-template <class T>
-void SZ_decompress(SZ3::Config &config, char *cmpData, size_t cmpSize, T *&decData) {
+template <class T, class Out>
+void SZ_decompress_convert(SZ3::Config &config, char *cmpData, size_t cmpSize, Out *&decData,
+                           SZ3::concepts::ExecutorInterface *executor = nullptr) {
     using namespace SZ3;
+    BindScope<concepts::ExecutorInterface> executorScope(executor);
     auto confPos = reinterpret_cast<const uchar *>(cmpData);
-    auto cmpDataPos = confPos + config.size_est();
     config.load(confPos);
+    size_t headerSize = Config::header_size(reinterpret_cast<const uchar *>(cmpData), confPos);
+    auto cmpDataPos = reinterpret_cast<const uchar *>(cmpData) + headerSize;
+    // the pipelines get the size of the data after the config
+    size_t cmpDataSize = cmpSize - headerSize;
 
     if (decData == nullptr) {
-        decData = new T[config.num];
+        decData = new Out[config.num];
     }
     if (config.N == 1) {
-        SZ_decompress_impl<T, 1>(config, cmpDataPos, cmpSize, decData);
+        SZ_decompress_impl<T, 1>(config, cmpDataPos, cmpDataSize, decData);
     } else if (config.N == 2) {
-        SZ_decompress_impl<T, 2>(config, cmpDataPos, cmpSize, decData);
+        SZ_decompress_impl<T, 2>(config, cmpDataPos, cmpDataSize, decData);
     } else if (config.N == 3) {
-        SZ_decompress_impl<T, 3>(config, cmpDataPos, cmpSize, decData);
+        SZ_decompress_impl<T, 3>(config, cmpDataPos, cmpDataSize, decData);
     } else if (config.N == 4) {
-        SZ_decompress_impl<T, 4>(config, cmpDataPos, cmpSize, decData);
+        SZ_decompress_impl<T, 4>(config, cmpDataPos, cmpDataSize, decData);
     } else {
         printf("Data dimension higher than 4 is not supported.\n");
         exit(0);
     }
 }
 
+/**
+ * API for decompression
+ * @tparam T decompressed data type
+ * @param config configuration placeholder. It will be overwritten by the compression configuration, except for settings
+ that are not stored in the compressed data (nThreads: number of threads for decompressing data compressed with openmp)
+ * @param cmpData compressed data
+ * @param cmpSize compressed data size in bytes
+ * @param decData pre-allocated buffer for decompressed data
+ * @param executor optional executor to decode the chunks of data compressed with openmp (or with an executor) on
+
+ example:
+ auto decData = new float[100*200*300];
+ SZ3::Config conf;
+ SZ_decompress(conf, cmpData, cmpSize, decData);
+
+ */
+template <class T>
+void SZ_decompress(SZ3::Config &config, char *cmpData, size_t cmpSize, T *&decData,
+                   SZ3::concepts::ExecutorInterface *executor = nullptr) {
+    SZ_decompress_convert<T>(config, cmpData, cmpSize, decData, executor);
+}
+
 /**
  * API for decompression
  * Similar with SZ_decompress(SZ3::Config &config, char *cmpData, size_t cmpSize, T *&decData)
@@ -159,11 +346,124 @@ void SZ_decompress(SZ3::Config &config, char *cmpData, size_t cmpSize, T *&decDa
  float decompressedData = SZ_decompress(conf, cmpData, cmpSize)
  */
 template <class T>
-T *SZ_decompress(SZ3::Config &config, char *cmpData, size_t cmpSize) {
+T *SZ_decompress(SZ3::Config &config, char *cmpData, size_t cmpSize,
+                 SZ3::concepts::ExecutorInterface *executor = nullptr) {
     using namespace SZ3;
     T *decData = nullptr;
-    SZ_decompress<T>(config, cmpData, cmpSize, decData);
+    SZ_decompress<T>(config, cmpData, cmpSize, decData, executor);
     return decData;
 }
 
+/**
+ * API for decompression into a strided view (see SZ_compress_strided)
+ * Data compressed with openmp (or with an executor) is scattered chunk by chunk, other data from a temporary array;
+ * the values outside of the view are left untouched.
+ *
+ * @tparam T decompressed data type
+ * @param config configuration placeholder. It will be overwritten by the compression configuration
+ * @param cmpData compressed data
+ * @param cmpSize compressed data size in bytes
+ * @param decData first value of the view, whose shape is the one of the compressed data
+ * @param strides distance in elements between consecutive indices of each dimension of the view, one per dimension
+ * @param executor optional executor to decode the chunks of data compressed with openmp (or with an executor) on
+ */
+template <class T>
+void SZ_decompress_strided(SZ3::Config &config, char *cmpData, size_t cmpSize, T *decData,
+                           const std::vector<size_t> &strides, SZ3::concepts::ExecutorInterface *executor = nullptr) {
+    using namespace SZ3;
+    BindScope<concepts::ExecutorInterface> executorScope(executor);
+    auto confPos = reinterpret_cast<const uchar *>(cmpData);
+    config.load(confPos);
+    size_t headerSize = Config::header_size(reinterpret_cast<const uchar *>(cmpData), confPos);
+    auto cmpDataPos = reinterpret_cast<const uchar *>(cmpData) + headerSize;
+    size_t cmpDataSize = cmpSize - headerSize;
+
+    if (strides.size() != config.dims.size()) {
+        throw std::invalid_argument("one stride per dimension is required");
+    }
+    if (config.N == 1) {
+        SZ_decompress_impl<T, 1>(config, cmpDataPos, cmpDataSize, decData, &strides);
+    } else if (config.N == 2) {
+        SZ_decompress_impl<T, 2>(config, cmpDataPos, cmpDataSize, decData, &strides);
+    } else if (config.N == 3) {
+        SZ_decompress_impl<T, 3>(config, cmpDataPos, cmpDataSize, decData, &strides);
+    } else if (config.N == 4) {
+        SZ_decompress_impl<T, 4>(config, cmpDataPos, cmpDataSize, decData, &strides);
+    } else {
+        printf("Data dimension higher than 4 is not supported.\n");
+        exit(0);
+    }
+}
+
+/**
+ * Number of independently decodable chunks in the compressed data
+ * Data compressed with openmp enabled is a container of chunks; otherwise the whole array is a single chunk.
+ * @param cmpData compressed data
+ * @param cmpSize compressed data size in bytes
+ */
+inline size_t SZ_chunk_count(char *cmpData, size_t cmpSize) {
+    using namespace SZ3;
+    Config config;
+    auto confPos = reinterpret_cast<const uchar *>(cmpData);
+    config.load(confPos);
+    auto cmpDataPos = reinterpret_cast<const uchar *>(cmpData) +
+                      Config::header_size(reinterpret_cast<const uchar *>(cmpData), confPos);
+    if (!config.openmp) {
+        return 1;
+    }
+    Container container;
+    container.load(cmpDataPos, config.dims);
+    return container.size();
+}
+
+/**
+ * API for decompressing a single chunk, without decoding the rest of the data
+ * @tparam T decompressed data type
+ * @param config configuration placeholder. It will be overwritten by the compression configuration of the whole array
+ * @param cmpData compressed data
+ * @param cmpSize compressed data size in bytes
+ * @param chunkId index of the chunk, in [0, SZ_chunk_count(cmpData, cmpSize))
+ * @param decData buffer for the chunk in row-major order of its own shape, allocated if nullptr
+ * @param origin position of the chunk in the whole array
+ * @param extent shape of the chunk
+ */
+template <class T>
+void SZ_decompress_chunk(SZ3::Config &config, char *cmpData, size_t cmpSize, size_t chunkId, T *&decData,
+                         std::vector<size_t> &origin, std::vector<size_t> &extent) {
+    using namespace SZ3;
+    auto confPos = reinterpret_cast<const uchar *>(cmpData);
+    Config wholeConf;
+    wholeConf.load(confPos);
+    auto cmpDataPos = reinterpret_cast<const uchar *>(cmpData) +
+                      Config::header_size(reinterpret_cast<const uchar *>(cmpData), confPos);
+
+    if (!wholeConf.openmp) {
+        if (chunkId != 0) {
+            throw std::out_of_range("chunk index out of range");
+        }
+        origin.assign(wholeConf.dims.size(), 0);
+        extent = wholeConf.dims;
+        SZ_decompress(config, cmpData, cmpSize, decData);
+        return;
+    }
+
+    Container container;
+    container.load(cmpDataPos, wholeConf.dims);
+    if (container.total_size() > cmpSize) {
+        throw std::invalid_argument("truncated SZ3 multi-chunk stream");
+    }
+    if (chunkId >= container.size()) {
+        throw std::out_of_range("chunk index out of range");
+    }
+    container.box(chunkId, origin, extent);
+    if (decData == nullptr) {
+        decData =
+            new T[std::accumulate(extent.begin(), extent.end(), static_cast<size_t>(1), std::multiplies<size_t>())];
+    }
+    if (!SZ_decompress_container_chunk<T>(wholeConf, container, cmpDataPos, chunkId, decData, true)) {
+        throw std::runtime_error("checksum mismatch, the compressed data is corrupted");
+    }
+    config = wholeConf;
+}
+
 #endif
@@ -11,6 +11,7 @@
 #include "SZ3/utils/Config.hpp"
 #include "SZ3/utils/FileUtil.hpp"
 #include "SZ3/utils/Timer.hpp"
+#include "SZ3/utils/Workspace.hpp"
 
 namespace SZ3 {
 /**
@@ -46,7 +47,8 @@ class SZGenericCompressor : public concepts::CompressorInterface<T> {
         size_t bufferSize = std::max<size_t>(
             1000, 1.2 * (decomposition.size_est() + encoder.size_est() + sizeof(T) * quant_inds.size()));
 
-        auto buffer = static_cast<uchar *>(malloc(bufferSize));
+        ScratchBuffer scratch(WS_LOSSLESS_SRC, bufferSize);
+        auto buffer = scratch.data();
         uchar *buffer_pos = buffer;
 
         decomposition.save(buffer_pos);
@@ -55,15 +57,20 @@ class SZGenericCompressor : public concepts::CompressorInterface<T> {
         encoder.encode(quant_inds, buffer_pos);
         encoder.postprocess_encode();
 
+        // decompression expects at most the size of the original data; larger (e.g., mostly unpredictable) data is left
+        // to lossless compression (see SZ_compress_dispatcher)
+        if (static_cast<size_t>(buffer_pos - buffer) > conf.num * sizeof(T)) {
+            return 0;
+        }
         auto cmpSize = lossless.compress(buffer, buffer_pos - buffer, cmpData, cmpCap);
-        free(buffer);
 
         return cmpSize;
     }
 
     T *decompress(const Config &conf, uchar const *cmpData, size_t cmpSize, T *decData) override {
         size_t bufferCap = conf.num * sizeof(T);
-        auto buffer = static_cast<uchar *>(malloc(bufferCap));
+        ScratchBuffer scratch(WS_LOSSLESS_DST, bufferCap);
+        auto buffer = scratch.data();
         lossless.decompress(cmpData, cmpSize, buffer, bufferCap);
 
         size_t remaining_length = bufferCap;
@@ -75,8 +82,6 @@ class SZGenericCompressor : public concepts::CompressorInterface<T> {
         auto quant_inds = encoder.decode(buffer_pos, conf.num);
         encoder.postprocess_decode();
 
-        free(buffer);
-
         decomposition.decompress(conf, quant_inds, decData);
         return decData;
     }
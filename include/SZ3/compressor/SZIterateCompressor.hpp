@@ -15,6 +15,7 @@
 #include "SZ3/utils/Iterator.hpp"
 #include "SZ3/utils/MemoryUtil.hpp"
 #include "SZ3/utils/Timer.hpp"
+#include "SZ3/utils/Workspace.hpp"
 
 namespace SZ3 {
 /**
@@ -87,7 +88,8 @@ class SZIterateCompressor : public concepts::CompressorInterface<T> {
         encoder.preprocess_encode(quant_inds, quantizer.get_out_range().second);
 
         size_t bufferSize = 1.2 * (quantizer.size_est() + encoder.size_est() + sizeof(T) * quant_inds.size());
-        auto buffer = static_cast<uchar *>(malloc(bufferSize));
+        ScratchBuffer scratch(WS_LOSSLESS_SRC, bufferSize);
+        auto buffer = scratch.data();
         uchar *buffer_pos = buffer;
 
         write(conf.num, buffer_pos);
@@ -103,15 +105,19 @@ class SZIterateCompressor : public concepts::CompressorInterface<T> {
 
         // assert(buffer_pos - buffer < bufferSize);
 
+        // too large for the decompression buffer (see SZGenericCompressor::compress)
+        if (static_cast<size_t>(buffer_pos - buffer) > conf.num * sizeof(T)) {
+            return 0;
+        }
         auto cmpSize = lossless.compress(buffer, buffer_pos - buffer, cmpData, cmpCap);
-        free(buffer);
         return cmpSize;
     }
 
     T *decompress(const Config &conf, uchar const *cmpData, size_t cmpSize, T *decData) override {
         //            Timer timer(true);
         size_t bufferCap = conf.num * sizeof(T);
-        auto buffer = static_cast<uchar *>(malloc(bufferCap));
+        ScratchBuffer scratch(WS_LOSSLESS_DST, bufferCap);
+        auto buffer = scratch.data();
         lossless.decompress(cmpData, cmpSize, buffer, bufferCap);
         size_t remaining_length = bufferCap;
         uchar const *buffer_pos = buffer;
@@ -135,7 +141,6 @@ class SZIterateCompressor : public concepts::CompressorInterface<T> {
         encoder.postprocess_decode();
         //            timer.stop("Decoder");
 
-        free(buffer);
         //            lossless.postdecompress_data(buffer);
 
         //            timer.start();
@@ -14,6 +14,7 @@
 #include "SZ3/utils/Interpolators.hpp"
 #include "SZ3/utils/Iterator.hpp"
 #include "SZ3/utils/MemoryUtil.hpp"
+#include "SZ3/utils/Workspace.hpp"
 
 /**
  * DO NOT use this one
@@ -35,7 +36,8 @@ class SZBlockInterpolationCompressor {
 
     T *decompress(const Config &conf, uchar const *cmpData, size_t cmpSize, T *decData) {
         size_t bufferCap = conf.num * sizeof(T);
-        auto buffer = static_cast<uchar *>(malloc(bufferCap));
+        ScratchBuffer scratch(WS_LOSSLESS_DST, bufferCap);
+        auto buffer = scratch.data();
         lossless.decompress(cmpData, cmpSize, buffer, bufferCap);
         size_t remaining_length = bufferCap;
         uchar const *buffer_pos = buffer;
@@ -55,7 +57,6 @@ class SZBlockInterpolationCompressor {
 
         encoder.postprocess_decode();
 
-        free(buffer);
 
         auto range = std::make_shared<multi_dimensional_range<T, N>>(decData, std::begin(global_dimensions),
                                                                      std::end(global_dimensions), block_size, 0);
@@ -140,7 +141,8 @@ class SZBlockInterpolationCompressor {
         encoder.preprocess_encode(quant_inds, quantizer.get_out_range().second);
         size_t bufferSize = 1.2 * (quantizer.size_est() + encoder.size_est() + sizeof(T) * quant_inds.size());
 
-        auto *buffer = static_cast<uchar *>(malloc(bufferSize));
+        ScratchBuffer scratch(WS_LOSSLESS_SRC, bufferSize);
+        auto buffer = scratch.data();
         uchar *buffer_pos = buffer;
 
         write(global_dimensions.data(), N, buffer_pos);
@@ -157,7 +159,6 @@ class SZBlockInterpolationCompressor {
         // assert(buffer_pos - buffer < bufferSize);
 
         auto cmpSize = lossless.compress(buffer, buffer_pos - buffer, cmpData, cmpCap);
-        free(buffer);
         return cmpSize;
         //            lossless.postcompress_data(buffer);
 
@@ -117,7 +117,8 @@ class LorenzoRegressionDecomposition : public concepts::DecompositionInterface<T
             indicator_huffman.postprocess_decode();
 
             if (reg_count) {
-                reg_params = decode_regression_coefficients(c, reg_count, size.block_size, precision, params);
+                reg_params =
+                    decode_regression_coefficients(c, remaining_length, reg_count, size.block_size, precision, params);
             }
         }
         quantizer.load(c, remaining_length);
@@ -159,11 +160,12 @@ class LorenzoRegressionDecomposition : public concepts::DecompositionInterface<T
     std::pair<int, int> get_out_range() override { return quantizer.get_out_range(); }
 
    private:
-    std::vector<int> compress_1d(T *data) {
+    std::vector<int> compress_1d(const T *data) {
         std::vector<int> quant_bins(conf.num);
-        quant_bins[0] = quantizer.quantize_and_overwrite(data[0], 0);
-        for (size_t i = 1; i < conf.num; i++) {
-            quant_bins[i] = quantizer.quantize_and_overwrite(data[i], data[i - 1]);
+        // keep the reconstructed neighbor in a rolling variable so the input is not modified
+        T prev = 0;
+        for (size_t i = 0; i < conf.num; i++) {
+            quant_bins[i] = quantizer.quantize_and_overwrite(data[i], prev, prev);
         }
         return quant_bins;
     }
@@ -224,8 +226,9 @@ class LorenzoRegressionDecomposition : public concepts::DecompositionInterface<T
         float *reg_params_pos = reg_params + RegCoeffNum3d;
         int *reg_params_type_pos = reg_params_type;
 
-        T reg_precisions[RegCoeffNum3d];
-        T reg_recip_precisions[RegCoeffNum3d];
+        // the coefficients are float, whatever the data type (the bounds of integer data would round to 0)
+        float reg_precisions[RegCoeffNum3d];
+        float reg_recip_precisions[RegCoeffNum3d];
         for (int i = 0; i < RegCoeffNum3d - 1; i++) {
             reg_precisions[i] = params.regression_param_eb_linear;
             reg_recip_precisions[i] = 1.0 / reg_precisions[i];
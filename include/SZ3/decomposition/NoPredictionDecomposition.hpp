@@ -26,7 +26,8 @@ class NoPredictionDecomposition : public concepts::DecompositionInterface<T, int
     std::vector<int> compress(const Config &conf, T *data) override {
         std::vector<int> quant_inds(conf.num);
         for (size_t i = 0; i < conf.num; i++) {
-            quant_inds[i] = quantizer.quantize_and_overwrite(data[i], 0);
+            T d = data[i];
+            quant_inds[i] = quantizer.quantize_and_overwrite(d, 0);
         }
         quantizer.postcompress_data();
         return quant_inds;
@@ -0,0 +1,43 @@
+#ifndef SZ3_EXECUTOR_HPP
+#define SZ3_EXECUTOR_HPP
+
+#include <functional>
+#include <future>
+
+namespace SZ3::concepts {
+
+/**
+ * Executors run the parallel parts of SZ3 (e.g., the chunks of a multi-chunk stream), so that SZ3 can share the thread
+ * pool of the host application instead of creating its own threads.
+ * While an executor is bound to the current thread (see BindScope in utils/Workspace.hpp), parallel code in SZ3 runs
+ * on it; otherwise OpenMP is used.
+ */
+class ExecutorInterface {
+   public:
+    virtual ~ExecutorInterface() = default;
+
+    /**
+     * @return number of tasks the executor runs at the same time
+     */
+    virtual int concurrency() const = 0;
+
+    /**
+     * run body(i) for i in [0, n) and return when all of them are done.
+     * Iterations are scheduled dynamically. The first exception thrown by body is rethrown after all iterations end.
+     */
+    virtual void parallel_for(size_t n, const std::function<void(size_t)> &body) = 0;
+
+    /**
+     * run a task asynchronously
+     * @return future for the completion (or the exception) of the task
+     */
+    virtual std::future<void> submit(std::function<void()> task) = 0;
+
+    static ExecutorInterface *&current() {
+        static thread_local ExecutorInterface *executor = nullptr;
+        return executor;
+    }
+};
+}  // namespace SZ3::concepts
+
+#endif  // SZ3_EXECUTOR_HPP
@@ -0,0 +1,70 @@
+#ifndef SZ3_EXECUTOR_OMP_HPP
+#define SZ3_EXECUTOR_OMP_HPP
+
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "SZ3/executor/Executor.hpp"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace SZ3 {
+/**
+ * Runs parallel loops on OpenMP threads; without OpenMP, loops run on the calling thread.
+ * The number of threads is passed to each parallel region, the global OpenMP setting is not changed.
+ */
+class Executor_omp : public concepts::ExecutorInterface {
+   public:
+    /**
+     * @param nThreads number of threads, 0 for the OpenMP default
+     */
+    explicit Executor_omp(int nThreads = 0) : nThreads(nThreads) {}
+
+    int concurrency() const override {
+#ifdef _OPENMP
+        return nThreads > 0 ? nThreads : omp_get_max_threads();
+#else
+        return 1;
+#endif
+    }
+
+    void parallel_for(size_t n, const std::function<void(size_t)> &body) override {
+        std::exception_ptr error;
+        std::mutex errorMutex;
+#pragma omp parallel for schedule(dynamic) num_threads(concurrency())
+        for (size_t i = 0; i < n; i++) {
+            // exceptions must not escape an OpenMP region
+            try {
+                body(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * OpenMP has no task queue outside of parallel regions, so each task runs on its own thread.
+     * (Not std::async, whose future would block in its destructor if the caller drops it.)
+     */
+    std::future<void> submit(std::function<void()> task) override {
+        std::packaged_task<void()> packaged(std::move(task));
+        auto future = packaged.get_future();
+        std::thread(std::move(packaged)).detach();
+        return future;
+    }
+
+   private:
+    int nThreads;
+};
+}  // namespace SZ3
+
+#endif  // SZ3_EXECUTOR_OMP_HPP
@@ -0,0 +1,29 @@
+#ifndef SZ3_EXECUTOR_SERIAL_HPP
+#define SZ3_EXECUTOR_SERIAL_HPP
+
+#include "SZ3/executor/Executor.hpp"
+
+namespace SZ3 {
+/**
+ * Runs everything on the calling thread
+ */
+class Executor_serial : public concepts::ExecutorInterface {
+   public:
+    int concurrency() const override { return 1; }
+
+    void parallel_for(size_t n, const std::function<void(size_t)> &body) override {
+        for (size_t i = 0; i < n; i++) {
+            body(i);
+        }
+    }
+
+    std::future<void> submit(std::function<void()> task) override {
+        std::packaged_task<void()> packaged(std::move(task));
+        auto future = packaged.get_future();
+        packaged();
+        return future;
+    }
+};
+}  // namespace SZ3
+
+#endif  // SZ3_EXECUTOR_SERIAL_HPP
@@ -0,0 +1,179 @@
+#ifndef SZ3_EXECUTOR_THREADPOOL_HPP
+#define SZ3_EXECUTOR_THREADPOOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SZ3/executor/Executor.hpp"
+
+namespace SZ3 {
+/**
+ * Work-stealing thread pool on std::thread.
+ * Each worker has its own task queue: tasks submitted from a worker go to its own queue and are taken LIFO, idle
+ * workers steal FIFO from the others. The thread calling parallel_for takes part in the loop, so nested parallel_for
+ * calls from inside a task do not deadlock.
+ */
+class Executor_threadpool : public concepts::ExecutorInterface {
+   public:
+    /**
+     * @param nThreads number of worker threads, 0 for the number of hardware threads
+     */
+    explicit Executor_threadpool(int nThreads = 0) {
+        if (nThreads <= 0) {
+            nThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        queues = std::vector<Queue>(nThreads);
+        for (int i = 0; i < nThreads; i++) {
+            workers.emplace_back([this, i] { run(i); });
+        }
+    }
+
+    ~Executor_threadpool() override {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wakeup.notify_all();
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    Executor_threadpool(const Executor_threadpool &) = delete;
+    Executor_threadpool &operator=(const Executor_threadpool &) = delete;
+
+    int concurrency() const override { return static_cast<int>(workers.size()); }
+
+    void parallel_for(size_t n, const std::function<void(size_t)> &body) override {
+        if (n == 0) {
+            return;
+        }
+        // shared with the helper tasks, which may start after this call has returned and then find no work left
+        struct Loop {
+            std::atomic<size_t> next{0}, done{0};
+            size_t n = 0;
+            const std::function<void(size_t)> *body = nullptr;
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        auto loop = std::make_shared<Loop>();
+        loop->n = n;
+        loop->body = &body;
+        auto work = [loop] {
+            for (size_t i = loop->next++; i < loop->n; i = loop->next++) {
+                try {
+                    (*loop->body)(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(loop->mutex);
+                    if (!loop->error) {
+                        loop->error = std::current_exception();
+                    }
+                }
+                if (++loop->done == loop->n) {
+                    std::lock_guard<std::mutex> lock(loop->mutex);
+                    loop->finished.notify_all();
+                }
+            }
+        };
+        size_t helpers = std::min(n - 1, workers.size());
+        for (size_t h = 0; h < helpers; h++) {
+            push(work);
+        }
+        work();
+        std::unique_lock<std::mutex> lock(loop->mutex);
+        loop->finished.wait(lock, [&] { return loop->done == n; });
+        if (loop->error) {
+            std::rethrow_exception(loop->error);
+        }
+    }
+
+    std::future<void> submit(std::function<void()> task) override {
+        auto packaged = std::make_shared<std::packaged_task<void()>>(std::move(task));
+        auto future = packaged->get_future();
+        push([packaged] { (*packaged)(); });
+        return future;
+    }
+
+   private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // the pool and the queue index of the current thread, if it is a worker
+    static std::pair<const Executor_threadpool *, size_t> &self() {
+        static thread_local std::pair<const Executor_threadpool *, size_t> worker{nullptr, 0};
+        return worker;
+    }
+
+    void push(std::function<void()> task) {
+        size_t q = self().first == this ? self().second : nextQueue++ % queues.size();
+        {
+            std::lock_guard<std::mutex> lock(queues[q].mutex);
+            queues[q].tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            pending++;
+        }
+        wakeup.notify_one();
+    }
+
+    bool take(size_t id, std::function<void()> &task) {
+        // own queue first (newest task), then steal from the others (oldest task)
+        for (size_t k = 0; k < queues.size(); k++) {
+            auto &queue = queues[(id + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                if (k == 0) {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                } else {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+                pending--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(size_t id) {
+        self() = {this, id};
+        // parallel code called from the tasks runs on this pool as well
+        concepts::ExecutorInterface::current() = this;
+        std::function<void()> task;
+        while (true) {
+            if (take(id, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wakeup.wait(lock, [this] { return stopping || pending > 0; });
+            if (stopping && pending == 0) {
+                return;
+            }
+        }
+    }
+
+    std::vector<Queue> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> nextQueue{0};
+    std::atomic<size_t> pending{0};
+    std::mutex sleepMutex;
+    std::condition_variable wakeup;
+    bool stopping = false;
+};
+}  // namespace SZ3
+
+#endif  // SZ3_EXECUTOR_THREADPOOL_HPP
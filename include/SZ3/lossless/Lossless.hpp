@@ -21,7 +21,7 @@ class LosslessInterface {
      * @param srcLen length (in bytes) of the data to be compressed
      * @param dst compressed data
      * @param dstCap capacity (in bytes) for storing the compressed data
-     * @return length (in bytes) of the data compressed
+     * @return length (in bytes) of the data compressed, or 0 if dstCap is not large enough
      */
     virtual size_t compress(uchar *src, size_t srcLen, uchar *dst, size_t dstCap) = 0;
 
@@ -5,6 +5,8 @@
 #ifndef SZ_LOSSLESS_BYPASS_HPP
 #define SZ_LOSSLESS_BYPASS_HPP
 
+#include <cstring>
+
 #include "SZ3/def.hpp"
 #include "SZ3/lossless/Lossless.hpp"
 
@@ -12,6 +14,9 @@ namespace SZ3 {
 class Lossless_bypass : public concepts::LosslessInterface {
    public:
     size_t compress(uchar *src, size_t srcLen, uchar *dst, size_t dstCap) override {
+        if (srcLen > dstCap) {
+            return 0;
+        }
         std::memcpy(dst, src, srcLen);
         // dst = src;
         return srcLen;
@@ -5,18 +5,122 @@
 #ifndef SZ_LOSSLESS_ZSTD_HPP
 #define SZ_LOSSLESS_ZSTD_HPP
 
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include "SZ3/def.hpp"
 #include "SZ3/lossless/Lossless.hpp"
+#include "SZ3/lossless/Lossless_bypass.hpp"
+#include "SZ3/lossless/ZstdDictionary.hpp"
+#include "SZ3/utils/Config.hpp"
+#include "SZ3/utils/MemoryUtil.hpp"
 #include "zstd.h"
 
 namespace SZ3 {
+/**
+ * zstd compression and decompression contexts that are reused across calls.
+ * Lossless_zstd uses the one bound to the current thread (see BindScope in utils/Workspace.hpp), otherwise a context
+ * owned by the thread, so zstd workspaces are not allocated in each call. Binding a context lets the caller control
+ * its lifetime (e.g., free the workspaces of a large compression); the context of the thread lives until it exits.
+ */
+class ZstdContext {
+   public:
+    ZstdContext() : cctx(ZSTD_createCCtx()), dctx(ZSTD_createDCtx()) {}
+
+    ~ZstdContext() {
+        ZSTD_freeCCtx(cctx);
+        ZSTD_freeDCtx(dctx);
+    }
+
+    ZstdContext(const ZstdContext &) = delete;
+    ZstdContext &operator=(const ZstdContext &) = delete;
+
+    static ZstdContext *&current() {
+        static thread_local ZstdContext *ctx = nullptr;
+        return ctx;
+    }
+
+    /**
+     * the bound context, otherwise the context owned by the current thread
+     */
+    static ZstdContext &get() {
+        auto ctx = current();
+        if (ctx != nullptr) {
+            return *ctx;
+        }
+        static thread_local ZstdContext threadContext;
+        return threadContext;
+    }
+
+    ZSTD_CCtx *cctx;
+    ZSTD_DCtx *dctx;
+};
+
+// payloads from this size on are compressed with the zstd worker threads (Config::zstdWorkers), smaller ones gain
+// nothing from splitting
+constexpr size_t SZ_ZSTD_MT_MIN_SIZE = 1 << 22;
+// largest zstd window decoders accept without raising their limit (ZSTD_WINDOWLOG_LIMIT_DEFAULT)
+constexpr int SZ_ZSTD_MAX_WINDOW_LOG = 27;
+// the adaptive mode (Config::lossless == 2) decides per block of this size whether zstd is worth running
+constexpr size_t SZ_ZSTD_ADAPTIVE_BLOCK = 1 << 20;
+// compressibility of a block is probed on this many slices of this size, spread over the block
+constexpr size_t SZ_ZSTD_PROBE_SIZE = 16384;
+constexpr int SZ_ZSTD_PROBES = 4;
+// blocks whose probes save less than this fraction are stored as is
+constexpr double SZ_ZSTD_MIN_SAVING = 0.01;
+
+/**
+ * zstd lossless stage, with the dictionary bound to the current thread if any (see ZstdDictionary).
+ * In the adaptive mode, blocks whose probes show that zstd would save little (typically Huffman codes of noisy data)
+ * are stored as is, the others are compressed; consecutive blocks with the same decision form one segment:
+ * flag (uchar, 0 -> raw, 1 -> zstd), original length (size_t), [zstd length (size_t)], payload.
+ */
 class Lossless_zstd : public concepts::LosslessInterface {
    public:
     Lossless_zstd() = default;
 
     Lossless_zstd(int comp_level) : compression_level(comp_level) {}
 
+    /**
+     * zstd settings of conf (zstdLevel, zstdLongDistance, zstdWindowLog, zstdWorkers), and the adaptive mode if
+     * conf.lossless == 2. Decompression needs the conf the data was compressed with.
+     */
+    explicit Lossless_zstd(const Config &conf)
+        : compression_level(conf.zstdLevel),
+          long_distance(conf.zstdLongDistance),
+          window_log(conf.zstdWindowLog),
+          workers(conf.zstdWorkers),
+          adaptive(conf.lossless == 2) {}
+
     size_t compress(uchar *src, size_t srcLen, uchar *dst, size_t dstCap) override {
+        if (auto trainer = ZstdDictionaryTrainer::current()) {
+            trainer->add(src, srcLen);
+        }
+        return adaptive ? compress_adaptive(src, srcLen, dst, dstCap) : compress_frame(src, srcLen, dst, dstCap);
+    }
+
+    size_t decompress(const uchar *src, const size_t srcLen, uchar *dst, size_t dstCap) override {
+        if (adaptive) {
+            return decompress_adaptive(src, srcLen, dst, dstCap);
+        }
+        //            const uchar *dataPos = data;
+        //            size_t dataLength = 0;
+        //            read(dataLength, dataPos, compressedSize);
+
+        //            uchar *oriData = new uchar[dataLength];
+        return decompress_frame(src, srcLen, dst, dstCap);
+        //            compressedSize = dataLength;
+        //            return oriData;
+    }
+
+   private:
+    static constexpr uchar SEGMENT_RAW = 0;
+    static constexpr uchar SEGMENT_ZSTD = 1;
+
+    size_t compress_frame(uchar *src, size_t srcLen, uchar *dst, size_t dstCap) {
         //            size_t estimatedCompressedSize = std::max(size_t(srcLen * 1.2), size_t(400));
         //            uchar *compressBytes = new uchar[estimatedCompressedSize];
         //            uchar *dstPos = dst;
@@ -25,24 +129,169 @@ class Lossless_zstd : public concepts::LosslessInterface {
         //                throw std::invalid_argument(
         //                    "dstCap not large enough for zstd");
         //            }
-        return ZSTD_compress(dst, dstCap, src, srcLen, compression_level);
+        ZSTD_CCtx *cctx = ZstdContext::get().cctx;
+        ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, compression_level);
+        if (long_distance) {
+            ZSTD_CCtx_setParameter(cctx, ZSTD_c_enableLongDistanceMatching, 1);
+        }
+        if (window_log > 0) {
+            ZSTD_CCtx_setParameter(cctx, ZSTD_c_windowLog, std::min(window_log, SZ_ZSTD_MAX_WINDOW_LOG));
+        }
+        if (workers > 0 && srcLen >= SZ_ZSTD_MT_MIN_SIZE) {
+            // fails (and is ignored) if zstd is built without ZSTD_MULTITHREAD
+            ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, workers);
+        }
+        if (auto dictionary = ZstdDictionary::current()) {
+            ZSTD_CCtx_refCDict(cctx, dictionary->cdict);
+        }
+        size_t dstLen = ZSTD_compress2(cctx, dst, dstCap, src, srcLen);
+        // dstCap too small (or other zstd errors) is reported as 0
+        return ZSTD_isError(dstLen) ? 0 : dstLen;
         //            dstLen += sizeof(size_t);
         //            return compressBytes;
     }
 
-    size_t decompress(const uchar *src, const size_t srcLen, uchar *dst, size_t dstCap) override {
-        //            const uchar *dataPos = data;
-        //            size_t dataLength = 0;
-        //            read(dataLength, dataPos, compressedSize);
+    /**
+     * frames compressed with a dictionary (see ZstdDictionary) need the same one bound to the current thread
+     */
+    size_t decompress_frame(const uchar *src, size_t srcLen, uchar *dst, size_t dstCap) {
+        ZSTD_DCtx *dctx = ZstdContext::get().dctx;
+        unsigned id = ZSTD_getDictID_fromFrame(src, srcLen);
+        if (id == 0) {
+            return ZSTD_decompressDCtx(dctx, dst, dstCap, src, srcLen);
+        }
+        auto dictionary = ZstdDictionary::current();
+        if (dictionary == nullptr || dictionary->id() != id) {
+            throw std::runtime_error("the data is compressed with zstd dictionary " + std::to_string(id) +
+                                     ", which must be bound (see ZstdDictionary) to decompress it");
+        }
+        return ZSTD_decompress_usingDDict(dctx, dst, dstCap, src, srcLen, dictionary->ddict);
+    }
 
-        //            uchar *oriData = new uchar[dataLength];
-        return ZSTD_decompress(dst, dstCap, src, srcLen);
-        //            compressedSize = dataLength;
-        //            return oriData;
+    /**
+     * whether zstd saves enough on the block to be worth its time, estimated on a few slices of the block: matches with
+     * a fast level, and the entropy coding of literals with the byte entropy (small slices are too short for zstd to
+     * entropy code them)
+     */
+    bool worth_compressing(const uchar *src, size_t len) const {
+        if (len <= SZ_ZSTD_PROBES * SZ_ZSTD_PROBE_SIZE) {
+            // probing costs about as much as compressing
+            return true;
+        }
+        ZSTD_CCtx *cctx = ZstdContext::get().cctx;
+        uchar probe[ZSTD_COMPRESSBOUND(SZ_ZSTD_PROBE_SIZE)];
+        size_t probeCmpSize = 0;
+        size_t freq[256] = {0};
+        for (int i = 0; i < SZ_ZSTD_PROBES; i++) {
+            const uchar *slice = src + (len - SZ_ZSTD_PROBE_SIZE) / (SZ_ZSTD_PROBES - 1) * i;
+            size_t size = ZSTD_compressCCtx(cctx, probe, sizeof(probe), slice, SZ_ZSTD_PROBE_SIZE,
+                                            std::min(compression_level, 1));
+            if (ZSTD_isError(size)) {
+                return true;
+            }
+            probeCmpSize += size;
+            for (size_t j = 0; j < SZ_ZSTD_PROBE_SIZE; j++) {
+                freq[slice[j]]++;
+            }
+        }
+        double probeSize = SZ_ZSTD_PROBES * SZ_ZSTD_PROBE_SIZE;
+        double entropy = 0;
+        for (auto f : freq) {
+            if (f != 0) {
+                entropy -= f / probeSize * std::log2(f / probeSize);
+            }
+        }
+        // zstd keeps entropy coded literals only if they save more than 1/64 of a block
+        double literalSaving = 1 - entropy / 8 > 1.0 / 64 ? 1 - entropy / 8 : 0;
+        double saving = std::max(1 - probeCmpSize / probeSize, literalSaving);
+        return saving >= SZ_ZSTD_MIN_SAVING;
+    }
+
+    size_t compress_adaptive(uchar *src, size_t srcLen, uchar *dst, size_t dstCap) {
+        size_t blockNum = (srcLen + SZ_ZSTD_ADAPTIVE_BLOCK - 1) / SZ_ZSTD_ADAPTIVE_BLOCK;
+        std::vector<bool> packed(blockNum);
+        for (size_t b = 0; b < blockNum; b++) {
+            size_t begin = b * SZ_ZSTD_ADAPTIVE_BLOCK;
+            packed[b] = worth_compressing(src + begin, std::min(SZ_ZSTD_ADAPTIVE_BLOCK, srcLen - begin));
+        }
+
+        uchar *dstPos = dst;
+        size_t b = 0;
+        while (b < blockNum) {
+            size_t e = b + 1;
+            while (e < blockNum && packed[e] == packed[b]) {
+                e++;
+            }
+            size_t begin = b * SZ_ZSTD_ADAPTIVE_BLOCK;
+            size_t len = std::min(e * SZ_ZSTD_ADAPTIVE_BLOCK, srcLen) - begin;
+            size_t left = dstCap - (dstPos - dst);
+            bool stored = false;
+            if (packed[b] && left > 1 + 2 * sizeof(size_t)) {
+                size_t cmpLen = compress_frame(src + begin, len, dstPos + 1 + 2 * sizeof(size_t),
+                                               std::min(left - 1 - 2 * sizeof(size_t), len));
+                if (cmpLen != 0 && cmpLen < len) {
+                    write(SEGMENT_ZSTD, dstPos);
+                    write(len, dstPos);
+                    write(cmpLen, dstPos);
+                    dstPos += cmpLen;
+                    stored = true;
+                }
+            }
+            if (!stored) {
+                if (left < 1 + sizeof(size_t) + len) {
+                    return 0;
+                }
+                write(SEGMENT_RAW, dstPos);
+                write(len, dstPos);
+                dstPos += Lossless_bypass().compress(src + begin, len, dstPos, len);
+            }
+            b = e;
+        }
+        return dstPos - dst;
+    }
+
+    size_t decompress_adaptive(const uchar *src, size_t srcLen, uchar *dst, size_t dstCap) {
+        const uchar *srcPos = src;
+        const uchar *srcEnd = src + srcLen;
+        uchar *dstPos = dst;
+        while (srcPos < srcEnd) {
+            uchar flag;
+            size_t len, cmpLen;
+            if (static_cast<size_t>(srcEnd - srcPos) < 1 + sizeof(size_t)) {
+                throw std::runtime_error("truncated segment header in adaptive zstd data");
+            }
+            read(flag, srcPos);
+            read(len, srcPos);
+            if (len > dstCap - (dstPos - dst)) {
+                throw std::runtime_error("adaptive zstd data is larger than the decompression buffer");
+            }
+            if (flag == SEGMENT_RAW) {
+                cmpLen = len;
+            } else if (static_cast<size_t>(srcEnd - srcPos) >= sizeof(size_t)) {
+                read(cmpLen, srcPos);
+            } else {
+                throw std::runtime_error("truncated segment header in adaptive zstd data");
+            }
+            if (cmpLen > static_cast<size_t>(srcEnd - srcPos)) {
+                throw std::runtime_error("truncated segment in adaptive zstd data");
+            }
+            if (flag == SEGMENT_RAW) {
+                Lossless_bypass().decompress(srcPos, len, dstPos, len);
+            } else if (decompress_frame(srcPos, cmpLen, dstPos, len) != len) {
+                throw std::runtime_error("corrupted segment in adaptive zstd data");
+            }
+            srcPos += cmpLen;
+            dstPos += len;
+        }
+        return dstPos - dst;
     }
 
-   private:
     int compression_level = 3;  // default setting of level is 3
+    bool long_distance = false;
+    int window_log = 0;  // 0 -> chosen by zstd from the level
+    int workers = 0;
+    bool adaptive = false;
 };
 }  // namespace SZ3
 #endif  // SZ_LOSSLESS_ZSTD_HPP
@@ -0,0 +1,117 @@
+#ifndef SZ_ZSTD_DICTIONARY_HPP
+#define SZ_ZSTD_DICTIONARY_HPP
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "SZ3/def.hpp"
+#include "zdict.h"
+#include "zstd.h"
+
+namespace SZ3 {
+// bytes kept from the start of each sample payload; the headers and Huffman trees a dictionary helps with come first
+constexpr size_t SZ_ZSTD_DICT_SAMPLE_SIZE = 1 << 16;
+// default dictionary size
+constexpr size_t SZ_ZSTD_DICT_CAPACITY = 1 << 15;
+
+/**
+ * A zstd dictionary for data compressed in many small pieces (e.g., HDF5 chunks), where each piece alone is too short
+ * for zstd to learn its headers and Huffman trees. The dictionary is digested once (ZSTD_CDict/ZSTD_DDict) and reused.
+ * While a dictionary is bound to the current thread (see BindScope in utils/Workspace.hpp), Lossless_zstd compresses
+ * with it; decompression needs the same dictionary bound, so it is stored once by the caller (e.g., as an HDF5
+ * attribute) next to the data.
+ */
+class ZstdDictionary {
+   public:
+    /**
+     * @param content dictionary trained by zstd (see ZstdDictionaryTrainer), e.g., as stored by the caller
+     * @param level compression level the dictionary is digested for
+     */
+    explicit ZstdDictionary(std::vector<uchar> content, int level = 3) : dict(std::move(content)) {
+        if (ZSTD_getDictID_fromDict(dict.data(), dict.size()) == 0) {
+            throw std::invalid_argument("not a trained zstd dictionary");
+        }
+        cdict = ZSTD_createCDict(dict.data(), dict.size(), level);
+        ddict = ZSTD_createDDict(dict.data(), dict.size());
+        if (cdict == nullptr || ddict == nullptr) {
+            ZSTD_freeCDict(cdict);
+            ZSTD_freeDDict(ddict);
+            throw std::runtime_error("failed to load the zstd dictionary");
+        }
+    }
+
+    ~ZstdDictionary() {
+        ZSTD_freeCDict(cdict);
+        ZSTD_freeDDict(ddict);
+    }
+
+    ZstdDictionary(const ZstdDictionary &) = delete;
+    ZstdDictionary &operator=(const ZstdDictionary &) = delete;
+
+    static ZstdDictionary *&current() {
+        static thread_local ZstdDictionary *dictionary = nullptr;
+        return dictionary;
+    }
+
+    /**
+     * serialized dictionary, to be stored with the data
+     */
+    const std::vector<uchar> &content() const { return dict; }
+
+    /**
+     * id recorded in the zstd frames compressed with the dictionary
+     */
+    unsigned id() const { return ZSTD_getDictID_fromDict(dict.data(), dict.size()); }
+
+    ZSTD_CDict *cdict = nullptr;
+    ZSTD_DDict *ddict = nullptr;
+
+   private:
+    std::vector<uchar> dict;
+};
+
+/**
+ * Collects the input of Lossless_zstd while bound to the current thread, to train a ZstdDictionary on the payloads of
+ * sample pieces of the data.
+ */
+class ZstdDictionaryTrainer {
+   public:
+    static ZstdDictionaryTrainer *&current() {
+        static thread_local ZstdDictionaryTrainer *trainer = nullptr;
+        return trainer;
+    }
+
+    void add(const uchar *src, size_t srcLen) {
+        size_t len = std::min(srcLen, SZ_ZSTD_DICT_SAMPLE_SIZE);
+        samples.insert(samples.end(), src, src + len);
+        sampleSizes.push_back(len);
+    }
+
+    size_t size() const { return sampleSizes.size(); }
+
+    /**
+     * Train a dictionary of at most capacity bytes on the collected payloads. zstd needs a fair number of samples
+     * (tens to hundreds) with content in common.
+     * @param level compression level the dictionary is digested for
+     */
+    std::unique_ptr<ZstdDictionary> train(size_t capacity = SZ_ZSTD_DICT_CAPACITY, int level = 3) const {
+        std::vector<uchar> dict(capacity);
+        size_t dictSize = ZDICT_trainFromBuffer(dict.data(), capacity, samples.data(), sampleSizes.data(),
+                                                static_cast<unsigned>(sampleSizes.size()));
+        if (ZDICT_isError(dictSize)) {
+            throw std::runtime_error(std::string("failed to train the zstd dictionary: ") +
+                                     ZDICT_getErrorName(dictSize));
+        }
+        dict.resize(dictSize);
+        return std::unique_ptr<ZstdDictionary>(new ZstdDictionary(std::move(dict), level));
+    }
+
+   private:
+    std::vector<uchar> samples;
+    std::vector<size_t> sampleSizes;
+};
+}  // namespace SZ3
+#endif  // SZ_ZSTD_DICTIONARY_HPP
@@ -48,10 +48,9 @@ void compress_regression_coefficient_3d(const int coeff_num, const T *precisions
 }
 
 template <typename T>
-float *decode_regression_coefficients(const unsigned char *&compressed_pos, size_t reg_count, int block_size,
-                                      T precision, const meta_params &params) {
+float *decode_regression_coefficients(const unsigned char *&compressed_pos, size_t remaining_length, size_t reg_count,
+                                      int block_size, T precision, const meta_params &params) {
     size_t reg_unpredictable_count = 0;
-    size_t remaining_length = RegCoeffNum3d * reg_count;  // fake, has no meaning
     SZ3::read(reg_unpredictable_count, compressed_pos, remaining_length);
     const float *reg_unpredictable_data_pos = reinterpret_cast<const float *>(compressed_pos);
     compressed_pos += reg_unpredictable_count * sizeof(float);
@@ -66,7 +65,7 @@ float *decode_regression_coefficients(const unsigned char *&compressed_pos, size
 
     float *reg_params = static_cast<float *>(malloc(RegCoeffNum3d * (reg_count + 1) * sizeof(float)));
     for (int i = 0; i < RegCoeffNum3d; i++) reg_params[i] = 0;
-    T reg_precisions[RegCoeffNum3d];
+    float reg_precisions[RegCoeffNum3d];
     for (int i = 0; i < RegCoeffNum3d - 1; i++) {
         reg_precisions[i] = params.regression_param_eb_linear;
     }
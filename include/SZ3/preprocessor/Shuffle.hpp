@@ -0,0 +1,194 @@
+#ifndef SZ3_SHUFFLE_HPP
+#define SZ3_SHUFFLE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "SZ3/def.hpp"
+#include "SZ3/utils/Config.hpp"
+
+namespace SZ3 {
+/**
+ * Reversible transform of the values ahead of a lossless compressor, like the shuffle filters of Blosc.
+ * The predictor (optional) replaces each value by its XOR with, or difference from, the previous value, on the bits of
+ * the values, so smooth data leaves mostly zero high bits. The shuffle then groups the same byte (SHUFFLE_BYTE) or bit
+ * (SHUFFLE_BIT) of all values, so that the sign, exponent and high mantissa bits, which vary little, form long
+ * repetitive runs for zstd.
+ *
+ * Layout of the output (num values of S bytes): byte shuffle, S streams of num bytes, stream k holding byte k of every
+ * value; bit shuffle, 8 * S planes of num / 8 bytes for the first num rounded down to 8 values, plane 8 * k + b holding
+ * bit b of byte k of every value, then bytes of the remaining values in byte shuffle order.
+ * The values are transformed in blocks with loops of fixed strides for each value size and predictor, so that the
+ * compiler vectorizes them.
+ */
+template <class T>
+class Shuffle {
+   public:
+    // unsigned integer with the bits of T
+    using U = typename std::conditional<
+        sizeof(T) == 1, uint8_t,
+        typename std::conditional<sizeof(T) == 2, uint16_t,
+                                  typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type>::type>::type;
+    static_assert(sizeof(U) == sizeof(T), "values must be 1, 2, 4 or 8 bytes");
+
+    Shuffle(uint8_t shuffle, uint8_t predictor) : shuffle(shuffle), predictor(predictor) {}
+
+    /**
+     * @param out num * sizeof(T) bytes
+     * @param tmp num * sizeof(T) bytes of scratch, used by SHUFFLE_BIT
+     */
+    void encode(const T *data, size_t num, uchar *out, uchar *tmp) const {
+        if (predictor == LOSSLESS_PRED_XOR) {
+            encode_bytes<LOSSLESS_PRED_XOR>(data, num, shuffle == SHUFFLE_BIT ? tmp : out);
+        } else if (predictor == LOSSLESS_PRED_DELTA) {
+            encode_bytes<LOSSLESS_PRED_DELTA>(data, num, shuffle == SHUFFLE_BIT ? tmp : out);
+        } else {
+            encode_bytes<LOSSLESS_PRED_NONE>(data, num, shuffle == SHUFFLE_BIT ? tmp : out);
+        }
+        if (shuffle == SHUFFLE_BIT) {
+            to_bit_planes(tmp, num, out);
+        }
+    }
+
+    /**
+     * inverse of encode
+     */
+    void decode(const uchar *in, size_t num, T *data, uchar *tmp) const {
+        if (shuffle == SHUFFLE_BIT) {
+            from_bit_planes(in, num, tmp);
+            in = tmp;
+        }
+        if (predictor == LOSSLESS_PRED_XOR) {
+            decode_bytes<LOSSLESS_PRED_XOR>(in, num, data);
+        } else if (predictor == LOSSLESS_PRED_DELTA) {
+            decode_bytes<LOSSLESS_PRED_DELTA>(in, num, data);
+        } else {
+            decode_bytes<LOSSLESS_PRED_NONE>(in, num, data);
+        }
+    }
+
+   private:
+    // values transformed at a time, small enough for the residuals to stay in L1
+    static constexpr size_t BLOCK = 256;
+
+    // predictor, then byte shuffle (or a copy without shuffle)
+    template <int P>
+    void encode_bytes(const T *data, size_t num, uchar *out) const {
+        constexpr size_t S = sizeof(T);
+        U cur[BLOCK + 1], res[BLOCK];
+        cur[0] = 0;
+        for (size_t begin = 0; begin < num; begin += BLOCK) {
+            size_t n = std::min(BLOCK, num - begin);
+            memcpy(cur + 1, data + begin, n * S);
+            for (size_t i = 0; i < n; i++) {
+                res[i] = P == LOSSLESS_PRED_XOR ? U(cur[i + 1] ^ cur[i])
+                                                : (P == LOSSLESS_PRED_DELTA ? U(cur[i + 1] - cur[i]) : cur[i + 1]);
+            }
+            cur[0] = cur[n];
+            if (shuffle == SHUFFLE_NONE) {
+                memcpy(out + begin * S, res, n * S);
+                continue;
+            }
+            for (size_t k = 0; k < S; k++) {
+                uchar *o = out + k * num + begin;
+                for (size_t i = 0; i < n; i++) {
+                    o[i] = static_cast<uchar>(res[i] >> (8 * k));
+                }
+            }
+        }
+    }
+
+    template <int P>
+    void decode_bytes(const uchar *in, size_t num, T *data) const {
+        constexpr size_t S = sizeof(T);
+        U res[BLOCK];
+        U prev = 0;
+        for (size_t begin = 0; begin < num; begin += BLOCK) {
+            size_t n = std::min(BLOCK, num - begin);
+            if (shuffle == SHUFFLE_NONE) {
+                memcpy(res, in + begin * S, n * S);
+            } else {
+                for (size_t i = 0; i < n; i++) {
+                    res[i] = in[begin + i];
+                }
+                for (size_t k = 1; k < S; k++) {
+                    const uchar *s = in + k * num + begin;
+                    for (size_t i = 0; i < n; i++) {
+                        res[i] |= U(U(s[i]) << (8 * k));
+                    }
+                }
+            }
+            if (P != LOSSLESS_PRED_NONE) {
+                for (size_t i = 0; i < n; i++) {
+                    prev = P == LOSSLESS_PRED_XOR ? U(res[i] ^ prev) : U(res[i] + prev);
+                    res[i] = prev;
+                }
+            }
+            memcpy(data + begin, res, n * S);
+        }
+    }
+
+    // transpose of the 8x8 bit matrix of 8 bytes (byte r of the result holds bit r of each byte), its own inverse
+    static uint64_t transpose8(uint64_t x) {
+        uint64_t t;
+        t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+        x = x ^ t ^ (t << 7);
+        t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+        x = x ^ t ^ (t << 14);
+        t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+        x = x ^ t ^ (t << 28);
+        return x;
+    }
+
+    // byte shuffled streams (src) to bit planes (dst)
+    static void to_bit_planes(const uchar *src, size_t num, uchar *dst) {
+        constexpr size_t S = sizeof(T);
+        size_t groups = num / 8;
+        for (size_t k = 0; k < S; k++) {
+            const uchar *s = src + k * num;
+            uchar *d = dst + k * groups * 8;
+            for (size_t g = 0; g < groups; g++) {
+                uint64_t x;
+                memcpy(&x, s + 8 * g, 8);
+                x = transpose8(x);
+                for (size_t b = 0; b < 8; b++) {
+                    d[b * groups + g] = static_cast<uchar>(x >> (8 * b));
+                }
+            }
+        }
+        // values after the last group of 8 stay in byte shuffle order, behind the planes
+        size_t rest = num - groups * 8;
+        for (size_t k = 0; k < S; k++) {
+            memcpy(dst + S * groups * 8 + k * rest, src + k * num + groups * 8, rest);
+        }
+    }
+
+    static void from_bit_planes(const uchar *src, size_t num, uchar *dst) {
+        constexpr size_t S = sizeof(T);
+        size_t groups = num / 8;
+        for (size_t k = 0; k < S; k++) {
+            const uchar *s = src + k * groups * 8;
+            uchar *d = dst + k * num;
+            for (size_t g = 0; g < groups; g++) {
+                uint64_t x = 0;
+                for (size_t b = 0; b < 8; b++) {
+                    x |= uint64_t(s[b * groups + g]) << (8 * b);
+                }
+                x = transpose8(x);
+                memcpy(d + 8 * g, &x, 8);
+            }
+        }
+        size_t rest = num - groups * 8;
+        for (size_t k = 0; k < S; k++) {
+            memcpy(dst + k * num + groups * 8, src + S * groups * 8 + k * rest, rest);
+        }
+    }
+
+    uint8_t shuffle;
+    uint8_t predictor;
+};
+}  // namespace SZ3
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef _SZ_INTEGER_QUANTIZER_HPP
+#define _SZ_INTEGER_QUANTIZER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "SZ3/def.hpp"
+#include "SZ3/quantizer/LinearQuantizer.hpp"
+#include "SZ3/quantizer/Quantizer.hpp"
+
+namespace SZ3 {
+
+/**
+ * Linear quantizer for integer data with exact integer arithmetic.
+ * The error bound is rounded down to an integer e, and each bin holds the 2 * e + 1 integers around its center, so the
+ * reconstructed values are integers within e of the original ones. Differences are taken as unsigned magnitudes, which
+ * never overflow, and no value goes through floating point.
+ * Data of earlier versions, quantized by LinearQuantizer, is still recovered (see load).
+ */
+template <class T>
+class IntegerQuantizer : public concepts::QuantizerInterface<T, int> {
+    static_assert(std::is_integral<T>::value, "IntegerQuantizer quantizes integer data");
+    // magnitude of the difference of two values of T
+    using U = typename std::conditional<sizeof(T) <= sizeof(uint32_t), uint32_t, uint64_t>::type;
+
+   public:
+    IntegerQuantizer() : radius(32768) { set_eb(1); }
+
+    IntegerQuantizer(double eb, int r = 32768) : radius(r) { set_eb(eb); }
+
+    double get_eb() const { return error_bound; }
+
+    void set_eb(double eb) {
+        error_bound = eb;
+        // capped so that the bin width fits in U; such a bound covers any two values of T anyway
+        half_width = static_cast<U>(std::fmin(std::floor(eb), std::ldexp(1.0, 8 * sizeof(U) - 2)));
+        width = 2 * half_width + 1;
+        reciprocal = (uint64_t(0xFFFFFFFF) / width) + 1;
+        // differences in the bins around the prediction, without overflow of diff + half_width
+        max_diff = static_cast<U>(std::min<uint64_t>(uint64_t(radius) * width, std::numeric_limits<U>::max()) -
+                                  half_width);
+        // values farther than half_width from the limits of T are reconstructed in its range
+        T lo = std::numeric_limits<T>::min(), hi = std::numeric_limits<T>::max();
+        bool narrow = half_width >= U(hi) - U(lo);
+        safe_min = narrow ? hi : T(U(lo) + half_width);
+        safe_max = narrow ? lo : T(U(hi) - half_width);
+    }
+
+    std::pair<int, int> get_out_range() const override { return std::make_pair(0, radius * 2); }
+
+    int quantize_and_overwrite(T &data, T pred) override { return quantize_and_overwrite(data, pred, data); }
+
+    /**
+     * quantize ori predicted by pred
+     * @param dest set to the reconstructed value
+     */
+    int quantize_and_overwrite(T ori, T pred, T &dest) {
+        bool below = ori < pred;
+        U diff = below ? U(pred) - U(ori) : U(ori) - U(pred);
+        if (diff < max_diff) {
+            // the nearest multiple of width, the reconstructed value pred +/- step is within half_width of ori
+            U q = divide(diff + half_width);
+            U step = q * width;
+            if ((ori >= safe_min && ori <= safe_max) || step <= diff ||
+                step - diff <= (below ? U(ori) - U(std::numeric_limits<T>::min())
+                                      : U(std::numeric_limits<T>::max()) - U(ori))) {
+                dest = static_cast<T>(below ? U(pred) - step : U(pred) + step);
+                return below ? radius - static_cast<int>(q) : radius + static_cast<int>(q);
+            }
+        }
+        unpred.push_back(ori);
+        dest = ori;
+        return 0;
+    }
+
+    // recover the data using the quantization index
+    T recover(T pred, int quant_index) override {
+        if (quant_index) {
+            return recover_pred(pred, quant_index);
+        } else {
+            return recover_unpred();
+        }
+    }
+
+    T recover_pred(T pred, int quant_index) {
+        if (legacy) {
+            return pred + 2 * (quant_index - this->radius) * this->error_bound;
+        }
+        // the result is in the range of T, so the wrapping arithmetic of uint64_t gives it exactly
+        return static_cast<T>(static_cast<uint64_t>(pred) +
+                              static_cast<uint64_t>(static_cast<int64_t>(quant_index - radius)) * width);
+    }
+
+    T recover_unpred() { return unpred[index++]; }
+
+    size_t size_est() { return unpred.size() * sizeof(T); }
+
+    void save(unsigned char *&c) const override {
+        c[0] = QUANTIZER_ID;
+        c += 1;
+        *reinterpret_cast<double *>(c) = this->error_bound;
+        c += sizeof(double);
+        *reinterpret_cast<int *>(c) = this->radius;
+        c += sizeof(int);
+        *reinterpret_cast<size_t *>(c) = unpred.size();
+        c += sizeof(size_t);
+        memcpy(c, unpred.data(), unpred.size() * sizeof(T));
+        c += unpred.size() * sizeof(T);
+    }
+
+    void load(const unsigned char *&c, size_t &remaining_length) override {
+        // integer data of earlier versions was quantized by LinearQuantizer, which saves the same layout
+        legacy = c[0] != QUANTIZER_ID;
+        c += sizeof(uint8_t);
+        remaining_length -= sizeof(uint8_t);
+        double eb = *reinterpret_cast<const double *>(c);
+        c += sizeof(double);
+        this->radius = *reinterpret_cast<const int *>(c);
+        c += sizeof(int);
+        set_eb(eb);
+        size_t unpred_size = *reinterpret_cast<const size_t *>(c);
+        c += sizeof(size_t);
+        this->unpred = std::vector<T>(reinterpret_cast<const T *>(c), reinterpret_cast<const T *>(c) + unpred_size);
+        c += unpred_size * sizeof(T);
+        index = 0;
+    }
+
+    void print() override {
+        printf("[IntegerQuantizer] error_bound = %llu, radius = %d, unpred = %lu\n",
+               static_cast<unsigned long long>(half_width), radius, unpred.size());
+    }
+
+   private:
+    static constexpr uchar QUANTIZER_ID = 0b00000011;
+
+    // diff / width; for 32 bits, without a division: diff * reciprocal / 2^32 is the quotient or one more
+    U divide(U diff) const {
+        if constexpr (sizeof(U) == sizeof(uint32_t)) {
+            uint64_t q = (static_cast<uint64_t>(diff) * reciprocal) >> 32;
+            return static_cast<U>(q * width > diff ? q - 1 : q);
+        } else {
+            return diff / width;
+        }
+    }
+
+    std::vector<T> unpred;
+    size_t index = 0;  // used in decompression only
+
+    double error_bound;
+    int radius;            // quantization interval radius
+    U half_width;          // integer error bound
+    U width;               // integers per bin
+    uint64_t reciprocal;   // ceil(2^32 / width), see divide
+    U max_diff;            // differences quantized in bins, see set_eb
+    T safe_min, safe_max;  // values with all their bins in the range of T
+    bool legacy = false;
+};
+
+/**
+ * quantizer of the SZ3 pipelines for data of type T
+ */
+template <class T>
+using DefaultQuantizer =
+    typename std::conditional<std::is_integral<T>::value, IntegerQuantizer<T>, LinearQuantizer<T>>::type;
+
+}  // namespace SZ3
+#endif
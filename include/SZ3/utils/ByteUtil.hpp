@@ -262,5 +262,26 @@ std::vector<T> bytes2vector(const unsigned char *&c, uint8_t bit_width, size_t n
     return data;
 }
 
+/**
+ * Adler-32 checksum of a byte array
+ */
+inline uint32_t adler32(const uchar *data, size_t len) {
+    const uint32_t mod = 65521;
+    uint32_t a = 1, b = 0;
+    while (len > 0) {
+        // 5552 is the largest n such that the sums do not overflow before the modulo
+        size_t n = std::min<size_t>(len, 5552);
+        len -= n;
+        for (size_t i = 0; i < n; i++) {
+            a += data[i];
+            b += a;
+        }
+        data += n;
+        a %= mod;
+        b %= mod;
+    }
+    return (b << 16) | a;
+}
+
 }  // namespace SZ3
 #endif  // SZ3_BYTEUTIL_HPP
@@ -5,9 +5,13 @@
 #ifndef SZ_Config_HPP
 #define SZ_Config_HPP
 
+#include <cassert>
 #include <cstdint>
 #include <iostream>
 #include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 #include "SZ3/def.hpp"
@@ -26,26 +30,45 @@
 #define SZ_INT32 7
 #define SZ_UINT64 8
 #define SZ_INT64 9
+#define SZ_FLOAT16 10
+#define SZ_BFLOAT16 11
+
+// first two bytes of the compact header (see Config::save); the fixed-layout header of earlier versions starts with
+// SZ3_MAGIC_NUMBER
+#define SZ3_COMPACT_MAGIC_NUMBER 0x33F3
+// data version of the fixed-layout header, the last one before the compact header
+#define SZ3_LEGACY_DATA_VER "3.2.0"
 
 namespace SZ3 {
 
-enum EB { EB_ABS, EB_REL, EB_PSNR, EB_L2NORM, EB_ABS_AND_REL, EB_ABS_OR_REL };
-constexpr const char *EB_STR[] = {"ABS", "REL", "PSNR", "NORM", "ABS_AND_REL", "ABS_OR_REL"};
-constexpr EB EB_OPTIONS[] = {EB_ABS, EB_REL, EB_PSNR, EB_L2NORM, EB_ABS_AND_REL, EB_ABS_OR_REL};
+enum EB { EB_ABS, EB_REL, EB_PSNR, EB_L2NORM, EB_ABS_AND_REL, EB_ABS_OR_REL, EB_RATIO, EB_BITRATE };
+constexpr const char *EB_STR[] = {"ABS", "REL", "PSNR", "NORM", "ABS_AND_REL", "ABS_OR_REL", "RATIO", "BITRATE"};
+constexpr EB EB_OPTIONS[] = {EB_ABS, EB_REL, EB_PSNR, EB_L2NORM, EB_ABS_AND_REL, EB_ABS_OR_REL, EB_RATIO, EB_BITRATE};
 
 enum ALGO {
     ALGO_LORENZO_REG,
     ALGO_INTERP_LORENZO,
     ALGO_INTERP,
     ALGO_NOPRED,
+    ALGO_LOSSLESS,
 };
-constexpr const char *ALGO_STR[] = {"ALGO_LORENZO_REG", "ALGO_INTERP_LORENZO", "ALGO_INTERP", "ALGO_NOPRED"};
-constexpr const ALGO ALGO_OPTIONS[] = {ALGO_LORENZO_REG, ALGO_INTERP_LORENZO, ALGO_INTERP, ALGO_NOPRED};
+constexpr const char *ALGO_STR[] = {"ALGO_LORENZO_REG", "ALGO_INTERP_LORENZO", "ALGO_INTERP", "ALGO_NOPRED",
+                                    "ALGO_LOSSLESS"};
+constexpr const ALGO ALGO_OPTIONS[] = {ALGO_LORENZO_REG, ALGO_INTERP_LORENZO, ALGO_INTERP, ALGO_NOPRED, ALGO_LOSSLESS};
 
 enum INTERP_ALGO { INTERP_ALGO_LINEAR, INTERP_ALGO_CUBIC };
 constexpr const char *INTERP_ALGO_STR[] = {"INTERP_ALGO_LINEAR", "INTERP_ALGO_CUBIC"};
 constexpr INTERP_ALGO INTERP_ALGO_OPTIONS[] = {INTERP_ALGO_LINEAR, INTERP_ALGO_CUBIC};
 
+// transforms of ALGO_LOSSLESS ahead of zstd, see preprocessor/Shuffle.hpp
+enum SHUFFLE { SHUFFLE_NONE, SHUFFLE_BYTE, SHUFFLE_BIT };
+constexpr const char *SHUFFLE_STR[] = {"SHUFFLE_NONE", "SHUFFLE_BYTE", "SHUFFLE_BIT"};
+constexpr SHUFFLE SHUFFLE_OPTIONS[] = {SHUFFLE_NONE, SHUFFLE_BYTE, SHUFFLE_BIT};
+
+enum LOSSLESS_PRED { LOSSLESS_PRED_NONE, LOSSLESS_PRED_XOR, LOSSLESS_PRED_DELTA };
+constexpr const char *LOSSLESS_PRED_STR[] = {"LOSSLESS_PRED_NONE", "LOSSLESS_PRED_XOR", "LOSSLESS_PRED_DELTA"};
+constexpr LOSSLESS_PRED LOSSLESS_PRED_OPTIONS[] = {LOSSLESS_PRED_NONE, LOSSLESS_PRED_XOR, LOSSLESS_PRED_DELTA};
+
 template <class T>
 const char *enum2Str(T e) {
     if (std::is_same<T, ALGO>::value) {
@@ -54,6 +77,10 @@ const char *enum2Str(T e) {
         return INTERP_ALGO_STR[e];
     } else if (std::is_same<T, EB>::value) {
         return EB_STR[e];
+    } else if (std::is_same<T, SHUFFLE>::value) {
+        return SHUFFLE_STR[e];
+    } else if (std::is_same<T, LOSSLESS_PRED>::value) {
+        return LOSSLESS_PRED_STR[e];
     } else {
         printf("invalid enum type for enum2Str()\n ");
         exit(0);
@@ -105,6 +132,8 @@ class Config {
             cmprAlgo = ALGO_INTERP;
         } else if (cmprAlgoStr == ALGO_STR[ALGO_NOPRED]) {
             cmprAlgo = ALGO_NOPRED;
+        } else if (cmprAlgoStr == ALGO_STR[ALGO_LOSSLESS]) {
+            cmprAlgo = ALGO_LOSSLESS;
         }
         auto ebModeStr = cfg.Get("GlobalSettings", "ErrorBoundMode", "");
         if (ebModeStr == EB_STR[EB_ABS]) {
@@ -119,13 +148,22 @@ class Config {
             errorBoundMode = EB_ABS_AND_REL;
         } else if (ebModeStr == EB_STR[EB_ABS_OR_REL]) {
             errorBoundMode = EB_ABS_OR_REL;
+        } else if (ebModeStr == EB_STR[EB_RATIO]) {
+            errorBoundMode = EB_RATIO;
+        } else if (ebModeStr == EB_STR[EB_BITRATE]) {
+            errorBoundMode = EB_BITRATE;
         }
         absErrorBound = cfg.GetReal("GlobalSettings", "AbsErrorBound", absErrorBound);
         relErrorBound = cfg.GetReal("GlobalSettings", "RelErrorBound", relErrorBound);
         psnrErrorBound = cfg.GetReal("GlobalSettings", "PSNRErrorBound", psnrErrorBound);
         l2normErrorBound = cfg.GetReal("GlobalSettings", "L2NormErrorBound", l2normErrorBound);
+        targetRatio = cfg.GetReal("GlobalSettings", "TargetCompressionRatio", targetRatio);
+        targetBitrate = cfg.GetReal("GlobalSettings", "TargetBitrate", targetBitrate);
 
         openmp = cfg.GetBoolean("GlobalSettings", "OpenMP", openmp);
+        nThreads = cfg.GetInteger("GlobalSettings", "OpenMPThreads", nThreads);
+        timeBudget = cfg.GetReal("GlobalSettings", "TimeBudget", timeBudget);
+        minThroughput = cfg.GetReal("GlobalSettings", "MinThroughput", minThroughput);
         lorenzo = cfg.GetBoolean("AlgoSettings", "Lorenzo", lorenzo);
         lorenzo2 = cfg.GetBoolean("AlgoSettings", "Lorenzo2ndOrder", lorenzo2);
         regression = cfg.GetBoolean("AlgoSettings", "Regression", regression);
@@ -140,126 +178,176 @@ class Config {
         interpDirection = cfg.GetInteger("AlgoSettings", "InterpolationDirection", interpDirection);
         blockSize = cfg.GetInteger("AlgoSettings", "BlockSize", blockSize);
         quantbinCnt = cfg.GetInteger("AlgoSettings", "QuantizationBinTotal", quantbinCnt);
+        lossless = cfg.GetInteger("AlgoSettings", "Lossless", lossless);
+        zstdLevel = cfg.GetInteger("AlgoSettings", "ZstdLevel", zstdLevel);
+        zstdLongDistance = cfg.GetBoolean("AlgoSettings", "ZstdLongDistanceMatching", zstdLongDistance);
+        zstdWindowLog = cfg.GetInteger("AlgoSettings", "ZstdWindowLog", zstdWindowLog);
+        zstdWorkers = cfg.GetInteger("AlgoSettings", "ZstdWorkers", zstdWorkers);
+
+        auto shuffleStr = cfg.Get("AlgoSettings", "LosslessShuffle", "");
+        for (auto option : SHUFFLE_OPTIONS) {
+            if (shuffleStr == SHUFFLE_STR[option]) {
+                losslessShuffle = option;
+            }
+        }
+        auto predictorStr = cfg.Get("AlgoSettings", "LosslessPredictor", "");
+        for (auto option : LOSSLESS_PRED_OPTIONS) {
+            if (predictorStr == LOSSLESS_PRED_STR[option]) {
+                losslessPredictor = option;
+            }
+        }
     }
 
+    /**
+     * Save the compact header: magic number, data version, dims, then the settings that differ from those of a default
+     * Config of the same dims (see save_delta). Settings are varints, except the error bounds.
+     * @return size in bytes, saved_size()
+     */
     size_t save(unsigned char *&c) {
         auto c0 = c;
-        write(sz3MagicNumber, c);
-        write(sz3DataVer, c);
+        write(static_cast<uint16_t>(SZ3_COMPACT_MAGIC_NUMBER), c);
+        sz3DataVer = versionInt(SZ3_DATA_VER);  // a Config loaded from a legacy header is re-saved as the current version
+        // versionInt leaves the low byte zero (major.minor.patch sit in the upper three), so it is not stored
+        assert((sz3DataVer & 0xFF) == 0);
+        write_varint(sz3DataVer >> 8, c);
         write(N, c);
-        // write(dims.data(), dims.size(), c);
-        auto bitWidth = vector_bit_width(dims);
-        write(bitWidth, c);
-        vector2bytes(dims, bitWidth, c);
-
-        write(num, c);
-        write(cmprAlgo, c);
-
-        write(errorBoundMode, c);
-        if (errorBoundMode == EB_ABS) {
-            write(absErrorBound, c);
-        } else if (errorBoundMode == EB_REL) {
-            write(relErrorBound, c);
-        } else if (errorBoundMode == EB_PSNR) {
-            write(psnrErrorBound, c);
-        } else if (errorBoundMode == EB_L2NORM) {
-            write(l2normErrorBound, c);
-        } else if (errorBoundMode == EB_ABS_OR_REL) {
-            write(absErrorBound, c);
-            write(relErrorBound, c);
-        } else if (errorBoundMode == EB_ABS_AND_REL) {
-            write(absErrorBound, c);
-            write(relErrorBound, c);
+        for (auto dim : dims) {
+            write_varint(dim, c);
         }
+        save_delta(c, default_config(dims));
+        assert(static_cast<size_t>(c - c0) == saved_size());
+        return c - c0;
+    }
 
-        uint8_t boolvals = (lorenzo & 1) << 7 | (lorenzo2 & 1) << 6 | (regression & 1) << 5 | (regression2 & 1) << 4 |
-                           (openmp & 1) << 3;
-        write(boolvals, c);
-
-        write(dataType, c);
-        write(lossless, c);
-        write(encoder, c);
-        write(interpAlgo, c);
-        write(interpDirection, c);
-
-        write(quantbinCnt, c);
-        write(blockSize, c);
-        write(stride, c);
-        write(pred_dim, c);
+    /**
+     * Size of the header save() would write now, without writing it
+     */
+    size_t saved_size() {
+        uint64_t present = 0, bit = 1;
+        size_t size = prefix_size(dims);
+        visit_saved(default_config(dims), [&](auto &field, const auto &baseField) {
+            if (field != baseField) {
+                present |= bit;
+                size += field_size(field);
+            }
+            bit <<= 1;
+        });
+        return size + varint_size(present);
+    }
 
-        // printf("%lu\n", c - c0);
-        return c - c0;
+    /**
+     * Smallest header of a stream with these dims, that of the default settings
+     */
+    static size_t min_saved_size(const std::vector<size_t> &dims_) { return prefix_size(dims_) + 1; }
+
+    /**
+     * Largest header of a stream with these dims, with every setting present at its widest encoding
+     */
+    static size_t max_saved_size(const std::vector<size_t> &dims_) {
+        auto conf = default_config(dims_);
+        uint64_t present = 0, bit = 1;
+        size_t size = prefix_size(dims_);
+        conf.visit_saved(conf, [&](auto &field, const auto &) {
+            present |= bit;
+            bit <<= 1;
+            using V = std::remove_reference_t<decltype(field)>;
+            // a varint holds 7 bits per byte, zigzag keeps signed values to the width of the type
+            size += std::is_floating_point<V>::value ? sizeof(V) : (sizeof(V) * 8 + 6) / 7;
+        });
+        return size + varint_size(present);
     }
 
+    /**
+     * Load the header written by save(), or the fixed-layout header of earlier versions (see header_size).
+     * Settings that are not stored in the header (e.g., nThreads) are kept.
+     */
     void load(const unsigned char *&c) {
-        // auto c0 = c;
-        read(sz3MagicNumber, c);
-        if (sz3MagicNumber != SZ3_MAGIC_NUMBER) {
-            throw std::invalid_argument("magic number mismatch, the input data is not compressed by SZ3");
+        uint16_t compactMagic;
+        memcpy(&compactMagic, c, sizeof(compactMagic));
+        if (compactMagic == SZ3_COMPACT_MAGIC_NUMBER) {
+            c += sizeof(compactMagic);
+            sz3MagicNumber = SZ3_MAGIC_NUMBER;
+            sz3DataVer = static_cast<uint32_t>(read_varint(c) << 8);
+        } else {
+            read(sz3MagicNumber, c);
+            if (sz3MagicNumber != SZ3_MAGIC_NUMBER) {
+                throw std::invalid_argument("magic number mismatch, the input data is not compressed by SZ3");
+            }
+            read(sz3DataVer, c);
         }
-        read(sz3DataVer, c);
-        if (versionStr(sz3DataVer) != SZ3_DATA_VER) {
+        auto expected = compactMagic == SZ3_COMPACT_MAGIC_NUMBER ? SZ3_DATA_VER : SZ3_LEGACY_DATA_VER;
+        if (versionStr(sz3DataVer) != expected) {
             std::stringstream ss;
             printf("program v%s , program-data %s , input data v%s\n", SZ3_VER, SZ3_DATA_VER,
                    versionStr(sz3DataVer).data());
             ss << "Please use SZ3 v" << versionStr(sz3DataVer) << " to decompress the data" << std::endl;
             throw std::invalid_argument(ss.str());
         }
+        if (compactMagic != SZ3_COMPACT_MAGIC_NUMBER) {
+            load_legacy(c);
+            return;
+        }
 
         read(N, c);
-
-        uint8_t bitWidth;
-        read(bitWidth, c);
-        dims = bytes2vector<size_t>(c, bitWidth, N);
-        // dims.resize(N);
-        // read(dims.data(), N, c);
-        read(num, c);
-        read(cmprAlgo, c);
-
-        read(errorBoundMode, c);
-        if (errorBoundMode == EB_ABS) {
-            read(absErrorBound, c);
-        } else if (errorBoundMode == EB_REL) {
-            read(relErrorBound, c);
-        } else if (errorBoundMode == EB_PSNR) {
-            read(psnrErrorBound, c);
-        } else if (errorBoundMode == EB_L2NORM) {
-            read(l2normErrorBound, c);
-        } else if (errorBoundMode == EB_ABS_OR_REL) {
-            read(absErrorBound, c);
-            read(relErrorBound, c);
-        } else if (errorBoundMode == EB_ABS_AND_REL) {
-            read(absErrorBound, c);
-            read(relErrorBound, c);
+        std::vector<size_t> dims_(N);
+        for (auto &dim : dims_) {
+            dim = read_varint(c);
         }
+        load_delta(c, default_config(dims_));
+        // as saved, setDims of the reference drops dims of size 1
+        dims = dims_;
+        N = static_cast<char>(dims.size());
+        num = std::accumulate(dims.begin(), dims.end(), static_cast<size_t>(1), std::multiplies<size_t>());
+    }
 
-        uint8_t boolvals;
-        read(boolvals, c);
-        lorenzo = (boolvals >> 7) & 1;
-        lorenzo2 = (boolvals >> 6) & 1;
-        regression = (boolvals >> 5) & 1;
-        regression2 = (boolvals >> 4) & 1;
-        openmp = (boolvals >> 3) & 1;
-
-        read(dataType, c);
-        read(lossless, c);
-        read(encoder, c);
-        read(interpAlgo, c);
-        read(interpDirection, c);
+    /**
+     * Save the settings that differ from base, a Config of the same dims known to the decoder (e.g., the Config of a
+     * chunk derived from the Config of the whole array): a varint of presence bits, one per setting, then the values
+     * of the settings present.
+     */
+    size_t save_delta(unsigned char *&c, const Config &base) {
+        auto c0 = c;
+        uint64_t present = 0, bit = 1;
+        visit_saved(base, [&](auto &field, const auto &baseField) {
+            present |= field != baseField ? bit : 0;
+            bit <<= 1;
+        });
+        write_varint(present, c);
+        visit_saved(base, [&](auto &field, const auto &baseField) {
+            if (field != baseField) {
+                write_field(field, c);
+            }
+        });
+        return c - c0;
+    }
 
-        read(quantbinCnt, c);
-        read(blockSize, c);
-        read(stride, c);
-        read(pred_dim, c);
+    /**
+     * Load the settings written by save_delta with the same base; the dims and the other settings are those of base.
+     */
+    void load_delta(const unsigned char *&c, const Config &base) {
+        N = base.N;
+        dims = base.dims;
+        num = base.num;
+        uint64_t present = read_varint(c), bit = 1;
+        visit_saved(base, [&](auto &field, const auto &baseField) {
+            if (present & bit) {
+                read_field(field, c);
+            } else {
+                field = baseField;
+            }
+            bit <<= 1;
+        });
+    }
 
-        // print();
-        // printf("%d\n", c - c0);
-        // if (c - c0 > size_est()) {
-        //     throw std::invalid_argument("Config loaded size is larger than estimated size");
-        // } else {
-        //     // for padding
-        //     c = c0 + size_est();
-        // }
+    /**
+     * Offset of the compressed data behind the header at the start of a stream produced by SZ_compress.
+     * Earlier versions reserved size_est() bytes for the header, the compact header is followed by the data.
+     * @param end position right after the header, as left by load()
+     */
+    static size_t header_size(const unsigned char *begin, const unsigned char *end) {
+        uint16_t compactMagic;
+        memcpy(&compactMagic, begin, sizeof(compactMagic));
+        return compactMagic == SZ3_COMPACT_MAGIC_NUMBER ? end - begin : size_est();
     }
 
     void print() {
@@ -278,13 +366,28 @@ class Config {
         printf("RelErrorBound = %f\n", relErrorBound);
         printf("PSNRErrorBound = %f\n", psnrErrorBound);
         printf("L2NormErrorBound = %f\n", l2normErrorBound);
+        printf("TargetCompressionRatio = %f\n", targetRatio);
+        printf("TargetBitrate = %f\n", targetBitrate);
         printf("Lorenzo = %d\n", lorenzo);
         printf("Lorenzo2ndOrder = %d\n", lorenzo2);
         printf("Regression = %d\n", regression);
         printf("Regression2ndOrder = %d\n", regression2);
         printf("OpenMP = %d\n", openmp);
+        printf("OpenMPThreads = %d\n", nThreads);
+        printf("ValueRange = %f\n", valueRange);
+        printf("FieldId = %d\n", fieldId);
+        printf("TimeBudget = %f\n", timeBudget);
+        printf("MinThroughput = %f\n", minThroughput);
+        printf("BudgetVariant = %d\n", budgetVariant);
+        printf("PredictedTime = %f\n", predictedTime);
         printf("DataType = %d\n", dataType);
         printf("Lossless = %d\n", lossless);
+        printf("ZstdLevel = %d\n", zstdLevel);
+        printf("ZstdLongDistanceMatching = %d\n", zstdLongDistance);
+        printf("ZstdWindowLog = %d\n", zstdWindowLog);
+        printf("ZstdWorkers = %d\n", zstdWorkers);
+        printf("LosslessShuffle = %s\n", enum2Str(static_cast<SHUFFLE>(losslessShuffle)));
+        printf("LosslessPredictor = %s\n", enum2Str(static_cast<LOSSLESS_PRED>(losslessPredictor)));
         printf("Encoder = %d\n", encoder);
         printf("InterpolationAlgo = %s\n", enum2Str(static_cast<INTERP_ALGO>(interpAlgo)));
         printf("InterpolationDirection = %d\n", interpDirection);
@@ -296,7 +399,10 @@ class Config {
     }
 
     static size_t size_est() {
-        return sizeof(Config) + sizeof(size_t) * 5;  // sizeof(size_t) * 5 is for dims vector
+        // fixed upper bound of the compact header (about 130 bytes with all settings present and 4 dims, see
+        // max_saved_size for the bound of given dims). Streams of earlier versions pad their fixed-layout header to
+        // this size.
+        return 160;
     }
 
     uint32_t sz3MagicNumber = SZ3_MAGIC_NUMBER;
@@ -310,20 +416,174 @@ class Config {
     double relErrorBound = 0.0;
     double psnrErrorBound = 0.0;
     double l2normErrorBound = 0.0;
+    double targetRatio = 0.0;    // compression ratio for EB_RATIO, reset to 0 once resolved
+    double targetBitrate = 0.0;  // bits per value for EB_BITRATE, reset to 0 once resolved
     bool lorenzo = true;
     bool lorenzo2 = false;
     bool regression = true;
     bool regression2 = false;
     bool openmp = false;
-    uint8_t dataType = SZ_FLOAT;  // dataType is only used in HDF5 filter
-    uint8_t lossless = 1;         // 0-> skip lossless(use lossless_bypass); 1-> zstd
-    uint8_t encoder = 1;          // 0-> skip encoder; 1->HuffmanEncoder; 2->ArithmeticEncoder
+    uint8_t dataType = SZ_FLOAT;    // set for half precision data (see Half.hpp), otherwise only used in HDF5 filter
+    uint8_t lossless = 2;           // 0-> skip lossless(use lossless_bypass); 1-> zstd; 2-> zstd where it pays off
+    int zstdLevel = 3;              // zstd compression level; not saved
+    bool zstdLongDistance = false;  // zstd long distance matching, for data with distant repetitions; not saved
+    int zstdWindowLog = 0;          // log2 of the zstd window (at most 27), 0 -> zstd default for the level; not saved
+    int zstdWorkers = 0;            // zstd threads for payloads of 4 MiB or more (needs ZSTD_MULTITHREAD); not saved
+    uint8_t encoder = 1;            // 0-> skip encoder; 1->HuffmanEncoder; 2->ArithmeticEncoder
+    // shuffle and predictor of ALGO_LOSSLESS; not saved (recorded in the compressed data)
+    uint8_t losslessShuffle = SHUFFLE_BYTE;
+    uint8_t losslessPredictor = LOSSLESS_PRED_DELTA;
     uint8_t interpAlgo = INTERP_ALGO_CUBIC;
     uint8_t interpDirection = 0;
     int quantbinCnt = 65536;
     int blockSize = 0;
-    int stride = 0;        // not used now
-    uint8_t pred_dim = 0;  // not used now
+    int stride = 0;            // not used now
+    uint8_t pred_dim = 0;      // not used now
+    int nThreads = 0;          // OpenMP threads for compression and decompression, 0 -> OpenMP default; not saved
+    double valueRange = -1;    // max - min of the data if known, < 0 -> computed when needed; an input, SZ caches the
+                               // computed range only in its own copies and never writes it to the caller's; not saved
+    int fieldId = -1;          // identifies the field in a TuningCache (e.g., the variable index); not saved
+    double timeBudget = 0;     // max seconds for compression, 0 -> no limit; reset to 0 once resolved; not saved
+    double minThroughput = 0;  // min GB/s of compression, 0 -> no limit; reset to 0 once resolved; not saved
+    int budgetVariant = 0;     // pipeline variant chosen for the time budget (see SZ_budget_variant); not saved
+    double predictedTime = 0;  // predicted seconds of the chosen variant, 0 without a time budget; not saved
+
+   private:
+    // Config of a stream with the given dims and default settings, the reference of the compact header
+    static Config default_config(const std::vector<size_t> &dims_) {
+        Config conf;
+        conf.setDims(dims_.begin(), dims_.end());
+        return conf;
+    }
+
+    // magic number, data version and dims, ahead of the settings in the header
+    static size_t prefix_size(const std::vector<size_t> &dims_) {
+        size_t size = sizeof(uint16_t) + varint_size(versionInt(SZ3_DATA_VER) >> 8) + sizeof(N);
+        for (auto dim : dims_) {
+            size += varint_size(dim);
+        }
+        return size;
+    }
+
+    // apply f(field, baseField) to the settings of the header, in the order of the presence bits
+    template <class F>
+    void visit_saved(const Config &base, F &&f) {
+        f(cmprAlgo, base.cmprAlgo);
+        f(errorBoundMode, base.errorBoundMode);
+        f(absErrorBound, base.absErrorBound);
+        f(relErrorBound, base.relErrorBound);
+        f(psnrErrorBound, base.psnrErrorBound);
+        f(l2normErrorBound, base.l2normErrorBound);
+        f(targetRatio, base.targetRatio);
+        f(targetBitrate, base.targetBitrate);
+        f(lorenzo, base.lorenzo);
+        f(lorenzo2, base.lorenzo2);
+        f(regression, base.regression);
+        f(regression2, base.regression2);
+        f(openmp, base.openmp);
+        f(dataType, base.dataType);
+        f(lossless, base.lossless);
+        f(encoder, base.encoder);
+        f(interpAlgo, base.interpAlgo);
+        f(interpDirection, base.interpDirection);
+        f(quantbinCnt, base.quantbinCnt);
+        f(blockSize, base.blockSize);
+        f(stride, base.stride);
+        f(pred_dim, base.pred_dim);
+    }
+
+    static uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+
+    // error bounds as they are, integers as varints (zigzag for signed ones)
+    template <class V>
+    static void write_field(V var, unsigned char *&c) {
+        if constexpr (std::is_floating_point<V>::value) {
+            write(var, c);
+        } else if constexpr (std::is_signed<V>::value) {
+            write_varint(zigzag(var), c);
+        } else {
+            write_varint(var, c);
+        }
+    }
+
+    // bytes written by write_field
+    template <class V>
+    static size_t field_size(V var) {
+        if constexpr (std::is_floating_point<V>::value) {
+            return sizeof(V);
+        } else if constexpr (std::is_signed<V>::value) {
+            return varint_size(zigzag(var));
+        } else {
+            return varint_size(var);
+        }
+    }
+
+    template <class V>
+    static void read_field(V &var, const unsigned char *&c) {
+        if constexpr (std::is_floating_point<V>::value) {
+            read(var, c);
+        } else if constexpr (std::is_signed<V>::value) {
+            uint64_t v = read_varint(c);
+            var = static_cast<V>(static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1));
+        } else {
+            var = static_cast<V>(read_varint(c));
+        }
+    }
+
+    // fixed layout of the header before the compact one, magic number and data version already read
+    void load_legacy(const unsigned char *&c) {
+        read(N, c);
+
+        uint8_t bitWidth;
+        read(bitWidth, c);
+        dims = bytes2vector<size_t>(c, bitWidth, N);
+        // dims.resize(N);
+        // read(dims.data(), N, c);
+        read(num, c);
+        read(cmprAlgo, c);
+
+        read(errorBoundMode, c);
+        if (errorBoundMode == EB_ABS) {
+            read(absErrorBound, c);
+        } else if (errorBoundMode == EB_REL) {
+            read(relErrorBound, c);
+        } else if (errorBoundMode == EB_PSNR) {
+            read(psnrErrorBound, c);
+        } else if (errorBoundMode == EB_L2NORM) {
+            read(l2normErrorBound, c);
+        } else if (errorBoundMode == EB_ABS_OR_REL) {
+            read(absErrorBound, c);
+            read(relErrorBound, c);
+        } else if (errorBoundMode == EB_ABS_AND_REL) {
+            read(absErrorBound, c);
+            read(relErrorBound, c);
+        } else if (errorBoundMode == EB_RATIO) {
+            read(targetRatio, c);
+        } else if (errorBoundMode == EB_BITRATE) {
+            read(targetBitrate, c);
+        }
+
+        uint8_t boolvals;
+        read(boolvals, c);
+        lorenzo = (boolvals >> 7) & 1;
+        lorenzo2 = (boolvals >> 6) & 1;
+        regression = (boolvals >> 5) & 1;
+        regression2 = (boolvals >> 4) & 1;
+        openmp = (boolvals >> 3) & 1;
+
+        read(dataType, c);
+        read(lossless, c);
+        // these streams ran zstd on the whole payload, whatever the setting (0 -> bypass and 2 -> adaptive came later)
+        lossless = 1;
+        read(encoder, c);
+        read(interpAlgo, c);
+        read(interpDirection, c);
+
+        read(quantbinCnt, c);
+        read(blockSize, c);
+        read(stride, c);
+        read(pred_dim, c);
+    }
 };
 
 }  // namespace SZ3
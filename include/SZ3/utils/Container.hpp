@@ -0,0 +1,312 @@
+#ifndef SZ3_CONTAINER_HPP
+#define SZ3_CONTAINER_HPP
+
+#include <stdexcept>
+#include <vector>
+
+#include "SZ3/def.hpp"
+#include "SZ3/utils/ByteUtil.hpp"
+#include "SZ3/utils/Config.hpp"
+#include "SZ3/utils/MemoryUtil.hpp"
+
+#define SZ3_CONTAINER_MAGIC_NUMBER 0xF342F331
+// containers of earlier versions: fixed-size fields, and a full Config in front of each payload
+#define SZ3_CONTAINER_LEGACY_MAGIC_NUMBER 0xF342F330
+
+namespace SZ3 {
+/**
+ * Location of one chunk payload in a container
+ */
+struct ChunkDescriptor {
+    uint64_t offset = 0;    // relative to the first payload
+    uint64_t size = 0;      // in bytes
+    uint32_t checksum = 0;  // adler32 of the payload
+};
+
+/**
+ * Index of a multi-chunk stream.
+ * The array is split by a regular grid into chunks of chunkDims elements (chunks on the upper edges may be smaller),
+ * numbered in row-major order of the grid. Each chunk is compressed independently, so chunks can be decoded by any
+ * number of threads, or one at a time.
+ *
+ * Layout: magic, N, chunkDims, number of chunks, descriptors (payload size and checksum; the offsets follow from the
+ * sizes), then the payloads. Sizes and counts are varints.
+ * The dims of the whole array are not stored here, they come from the Config in front of the container. Each payload
+ * starts with the settings of its chunk that differ from those of the whole array (see Config::save_delta).
+ */
+class Container {
+   public:
+    Container() = default;
+
+    Container(const std::vector<size_t> &dims, const std::vector<size_t> &chunkDims) { init(dims, chunkDims); }
+
+    size_t size() const { return chunks.size(); }
+
+    ChunkDescriptor &operator[](size_t i) { return chunks[i]; }
+
+    const ChunkDescriptor &operator[](size_t i) const { return chunks[i]; }
+
+    /**
+     * position and shape of chunk i in the whole array
+     */
+    void box(size_t i, std::vector<size_t> &origin, std::vector<size_t> &extent) const {
+        origin.resize(dims.size());
+        extent.resize(dims.size());
+        for (size_t d = dims.size(); d-- > 0;) {
+            origin[d] = (i % grid[d]) * chunkDims[d];
+            extent[d] = std::min(chunkDims[d], dims[d] - origin[d]);
+            i /= grid[d];
+        }
+    }
+
+    /**
+     * serialized size of the header and the descriptors, with the current chunk sizes
+     */
+    size_t header_size() const {
+        if (legacy) {
+            return sizeof(uint32_t) + sizeof(uint8_t) + dims.size() * sizeof(uint64_t) + sizeof(uint64_t) +
+                   chunks.size() * (2 * sizeof(uint64_t) + sizeof(uint32_t));
+        }
+        size_t size = sizeof(uint32_t) + sizeof(uint8_t) + varint_size(chunks.size());
+        for (auto d : chunkDims) {
+            size += varint_size(d);
+        }
+        for (const auto &chunk : chunks) {
+            size += varint_size(chunk.size) + sizeof(uint32_t);
+        }
+        return size;
+    }
+
+    /**
+     * upper bound of header_size() for any chunk sizes
+     */
+    size_t header_bound() const {
+        return sizeof(uint32_t) + sizeof(uint8_t) + (dims.size() + 1) * varint_size(UINT64_MAX) +
+               chunks.size() * (varint_size(UINT64_MAX) + sizeof(uint32_t));
+    }
+
+    /**
+     * total size of the container, including the payloads
+     */
+    size_t total_size() const {
+        return header_size() + (chunks.empty() ? 0 : chunks.back().offset + chunks.back().size);
+    }
+
+    /**
+     * whether the payloads start with the settings of the chunk relative to the whole array (Config::save_delta),
+     * rather than a full Config as in earlier versions
+     */
+    bool delta_headers() const { return !legacy; }
+
+    /**
+     * the chunks must be contiguous and in order (offset of each chunk = end of the previous one)
+     */
+    void save(uchar *&c) const {
+        write(static_cast<uint32_t>(SZ3_CONTAINER_MAGIC_NUMBER), c);
+        write(static_cast<uint8_t>(dims.size()), c);
+        for (auto d : chunkDims) {
+            write_varint(d, c);
+        }
+        write_varint(chunks.size(), c);
+        for (const auto &chunk : chunks) {
+            write_varint(chunk.size, c);
+            write(chunk.checksum, c);
+        }
+    }
+
+    /**
+     * @param dims dims of the whole array
+     */
+    void load(const uchar *&c, const std::vector<size_t> &dims) {
+        uint32_t magic;
+        read(magic, c);
+        if (magic != SZ3_CONTAINER_MAGIC_NUMBER && magic != SZ3_CONTAINER_LEGACY_MAGIC_NUMBER) {
+            throw std::invalid_argument("magic number mismatch, the input is not an SZ3 multi-chunk stream");
+        }
+        uint8_t n;
+        read(n, c);
+        if (n != dims.size()) {
+            throw std::invalid_argument("dimension mismatch in SZ3 multi-chunk stream");
+        }
+        if (magic == SZ3_CONTAINER_LEGACY_MAGIC_NUMBER) {
+            load_legacy(c, dims);
+            return;
+        }
+        std::vector<size_t> chunkDims_(n);
+        for (auto &d : chunkDims_) {
+            d = read_varint(c);
+        }
+        init(dims, chunkDims_);
+        if (read_varint(c) != chunks.size()) {
+            throw std::invalid_argument("chunk count mismatch in SZ3 multi-chunk stream");
+        }
+        uint64_t offset = 0;
+        for (auto &chunk : chunks) {
+            chunk.offset = offset;
+            chunk.size = read_varint(c);
+            read(chunk.checksum, c);
+            offset += chunk.size;
+        }
+    }
+
+   private:
+    void load_legacy(const uchar *&c, const std::vector<size_t> &dims_) {
+        std::vector<size_t> chunkDims_(dims_.size());
+        for (auto &d : chunkDims_) {
+            uint64_t v;
+            read(v, c);
+            d = v;
+        }
+        init(dims_, chunkDims_);
+        legacy = true;
+        uint64_t count;
+        read(count, c);
+        if (count != chunks.size()) {
+            throw std::invalid_argument("chunk count mismatch in SZ3 multi-chunk stream");
+        }
+        for (auto &chunk : chunks) {
+            read(chunk.offset, c);
+            read(chunk.size, c);
+            read(chunk.checksum, c);
+        }
+    }
+
+    void init(const std::vector<size_t> &dims_, const std::vector<size_t> &chunkDims_) {
+        dims = dims_;
+        chunkDims = chunkDims_;
+        legacy = false;
+        grid.resize(dims.size());
+        size_t count = 1;
+        for (size_t d = 0; d < dims.size(); d++) {
+            if (chunkDims[d] == 0) {
+                throw std::invalid_argument("chunk dims must be positive");
+            }
+            grid[d] = (dims[d] + chunkDims[d] - 1) / chunkDims[d];
+            count *= grid[d];
+        }
+        chunks.assign(count, ChunkDescriptor());
+    }
+
+    std::vector<size_t> dims, chunkDims, grid;
+    std::vector<ChunkDescriptor> chunks;
+    bool legacy = false;
+};
+
+/**
+ * Config for a sub-block of the data.
+ * Settings that depend on the dimension (blockSize, stride, pred_dim) are kept unless the sub-block loses dimensions of
+ * size 1, in which case the defaults of the lower dimension are used.
+ */
+template <class Iter>
+Config sub_config(const Config &conf, Iter begin, Iter end) {
+    Config sub = conf;
+    sub.setDims(begin, end);
+    if (sub.N == conf.N) {
+        sub.blockSize = conf.blockSize;
+        sub.stride = conf.stride;
+        sub.pred_dim = conf.pred_dim;
+    } else {
+        sub.interpDirection = 0;
+    }
+    return sub;
+}
+
+/**
+ * Copy the box [origin, origin + extent) of a strided array between the array and a dense buffer.
+ * The values are converted if the array and the buffer have different types.
+ * @param strides distance in elements between consecutive indices of each dimension of the array, e.g., {ny * 6, 6}
+ * for one field of an nx x ny array of structures of 6 fields
+ * @param toBox true to copy from the array into the buffer, false to copy from the buffer back into the array
+ */
+template <class T, class B>
+void copy_box_strided(T *array, const std::vector<size_t> &strides, B *box, const std::vector<size_t> &origin,
+                      const std::vector<size_t> &extent, bool toBox) {
+    size_t N = strides.size();
+    size_t rowLen = extent[N - 1];
+    size_t step = strides[N - 1];
+    size_t rows = 1;
+    for (size_t d = 0; d + 1 < N; d++) {
+        rows *= extent[d];
+    }
+    std::vector<size_t> idx(N, 0);
+    for (size_t r = 0; r < rows; r++) {
+        size_t offset = 0;
+        for (size_t d = 0; d < N; d++) {
+            offset += (origin[d] + idx[d]) * strides[d];
+        }
+        T *row = array + offset;
+        B *boxRow = box + r * rowLen;
+        if (step == 1) {
+            if (toBox) {
+                std::copy_n(row, rowLen, boxRow);
+            } else {
+                std::copy_n(boxRow, rowLen, row);
+            }
+        } else if (toBox) {
+            for (size_t j = 0; j < rowLen; j++) {
+                boxRow[j] = row[j * step];
+            }
+        } else {
+            for (size_t j = 0; j < rowLen; j++) {
+                row[j * step] = boxRow[j];
+            }
+        }
+        for (size_t d = N - 1; d-- > 0;) {
+            if (++idx[d] < extent[d]) {
+                break;
+            }
+            idx[d] = 0;
+        }
+    }
+}
+
+/**
+ * strides of a dense array in C order, the last dimension being the fastest
+ */
+inline std::vector<size_t> dense_strides(const std::vector<size_t> &dims) {
+    std::vector<size_t> strides(dims.size(), 1);
+    for (size_t d = dims.size() - 1; d-- > 0;) {
+        strides[d] = strides[d + 1] * dims[d + 1];
+    }
+    return strides;
+}
+
+/**
+ * Copy the box [origin, origin + extent) of a dense array between the array and a dense buffer (see copy_box_strided).
+ */
+template <class T, class B>
+void copy_box(T *array, const std::vector<size_t> &dims, B *box, const std::vector<size_t> &origin,
+              const std::vector<size_t> &extent, bool toBox) {
+    copy_box_strided(array, dense_strides(dims), box, origin, extent, toBox);
+}
+
+/**
+ * whether the box is one contiguous range of the array, i.e., it spans the whole array in all but the slowest
+ * dimension that is larger than 1
+ */
+inline bool box_is_contiguous(const std::vector<size_t> &dims, const std::vector<size_t> &extent) {
+    size_t d = 0;
+    while (d < dims.size() && extent[d] == 1) {
+        d++;
+    }
+    for (d++; d < dims.size(); d++) {
+        if (extent[d] != dims[d]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * offset of the first element of the box in the array
+ */
+inline size_t box_offset(const std::vector<size_t> &dims, const std::vector<size_t> &origin) {
+    size_t offset = 0;
+    for (size_t d = 0; d < dims.size(); d++) {
+        offset = offset * dims[d] + origin[d];
+    }
+    return offset;
+}
+}  // namespace SZ3
+
+#endif
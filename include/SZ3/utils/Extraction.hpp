@@ -5,10 +5,20 @@
 #ifndef SZ_EXTRACTION_HPP
 #define SZ_EXTRACTION_HPP
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+#include "SZ3/utils/Container.hpp"
+
 namespace SZ3 {
 
 template <uint N>
-float cal_sampling_ratio(size_t block, size_t n, size_t dmin, std::vector<size_t> dims) {
+float cal_sampling_ratio(size_t block, size_t n, size_t dmin, const std::vector<size_t> &dims) {
     size_t sample_n = 1;
     for (auto dim : dims) {
         sample_n *= dim / dmin * 2 * block;
@@ -16,87 +26,27 @@ float cal_sampling_ratio(size_t block, size_t n, size_t dmin, std::vector<size_t
     return sample_n * 1.0 / n;
 }
 
+/**
+ * Sample the data for auto-tuning.
+ * Along each dimension, every block of dmin elements contributes two runs of sampling_block elements, so the sample
+ * keeps the local structure of the data. Runs along the last dimension are contiguous and copied as a whole.
+ * @return the sample with shape sample_dims, or an empty vector if the data is too small to be sampled (then
+ * sample_num is the size of the data)
+ */
 template <class T, uint N>
-inline typename std::enable_if<N == 4, std::vector<T>>::type sampling(T *data, std::vector<size_t> dims,
-                                                                      size_t &sample_num,
-                                                                      std::vector<size_t> &sample_dims,
-                                                                      size_t &sampling_block) {
+std::vector<T> sampling(const T *data, std::vector<size_t> dims, size_t &sample_num, std::vector<size_t> &sample_dims,
+                        size_t &sampling_block) {
     assert(dims.size() == N);
     assert(sample_dims.size() == N);
-    Timer timer(true);
     size_t num = std::accumulate(dims.begin(), dims.end(), static_cast<size_t>(1), std::multiplies<size_t>());
 
     size_t dmin = *std::min_element(dims.begin(), dims.end());
-    sampling_block = dmin;
-    while (cal_sampling_ratio<N>(sampling_block, num, dmin, dims) > 0.035) {
-        sampling_block--;
-    }
-    if (sampling_block * 2 > dmin) {
-        sampling_block = dmin / 2;
-    }
-    if (sampling_block < 9) {
-        sample_dims = dims;
-        sample_num = num;
-        return std::vector<T>();
-    }
-    size_t b0 = dims[0] / dmin;
-    size_t b1 = dims[1] / dmin;
-    size_t b2 = dims[2] / dmin;
-    size_t b3 = dims[3] / dmin;
-    sample_dims[0] = b0 * 2 * sampling_block;
-    sample_dims[1] = b1 * 2 * sampling_block;
-    sample_dims[2] = b2 * 2 * sampling_block;
-    sample_dims[3] = b3 * 2 * sampling_block;
-    size_t di, dj, dk, dt;
-    sample_num = sample_dims[0] * sample_dims[1] * sample_dims[2] * sample_dims[3];
-    std::vector<T> sampling_data(sample_num, 0);
-
-    for (size_t bi = 0; bi < b0; bi++) {
-        for (size_t bj = 0; bj < b1; bj++) {
-            for (size_t bk = 0; bk < b2; bk++) {
-                for (size_t bt = 0; bt < b3; bt++) {
-                    for (size_t i = 0; i < 2 * sampling_block; i++) {
-                        for (size_t j = 0; j < 2 * sampling_block; j++) {
-                            for (size_t k = 0; k < 2 * sampling_block; k++) {
-                                for (size_t t = 0; t < 2 * sampling_block; t++) {
-                                    di = i < sampling_block ? i + sampling_block : dmin - 3 * sampling_block + i;
-                                    dj = j < sampling_block ? j + sampling_block : dmin - 3 * sampling_block + j;
-                                    dk = k < sampling_block ? k + sampling_block : dmin - 3 * sampling_block + k;
-                                    dt = t < sampling_block ? t + sampling_block : dmin - 3 * sampling_block + t;
-                                    size_t idx = (bi * dmin + di) * dims[1] * dims[2] * dims[3] +
-                                                 (bj * dmin + dj) * dims[2] * dims[3] + (bk * dmin + dk) * dims[3] +
-                                                 bt * dmin + dt;
-                                    sampling_data[(bi * 2 * sampling_block + i) * sample_dims[1] * sample_dims[2] *
-                                                      sample_dims[3] +
-                                                  (bj * 2 * sampling_block + j) * sample_dims[1] * sample_dims[2] +
-                                                  (bk * 2 * sampling_block + k) * sample_dims[2] +
-                                                  bt * 2 * sampling_block + t] = data[idx];
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
+    // largest block with a sampling ratio of at most 3.5%, searched down from an estimate instead of from dmin
+    size_t nBlocks = 1;
+    for (auto dim : dims) {
+        nBlocks *= dim / dmin;
     }
-    //        auto sampling_time = timer.stop();
-    //        printf("Generate sampling data, block = %lu percent = %.3f%% Time = %.3f \n", sampling_block, sample_num *
-    //        100.0 / num,
-    //               sampling_time);
-    return sampling_data;
-}
-
-template <class T, uint N>
-inline typename std::enable_if<N == 3, std::vector<T>>::type sampling(T *data, std::vector<size_t> dims,
-                                                                      size_t &sample_num,
-                                                                      std::vector<size_t> &sample_dims,
-                                                                      size_t &sampling_block) {
-    assert(dims.size() == N);
-    assert(sample_dims.size() == N);
-    size_t num = std::accumulate(dims.begin(), dims.end(), static_cast<size_t>(1), std::multiplies<size_t>());
-
-    size_t dmin = *std::min_element(dims.begin(), dims.end());
-    sampling_block = dmin;
+    sampling_block = std::min(dmin, static_cast<size_t>(std::pow(0.035 * num / nBlocks, 1.0 / N) / 2) + 2);
     while (cal_sampling_ratio<N>(sampling_block, num, dmin, dims) > 0.035) {
         sampling_block--;
     }
@@ -108,134 +58,80 @@ inline typename std::enable_if<N == 3, std::vector<T>>::type sampling(T *data, s
         sample_num = num;
         return std::vector<T>();
     }
-    size_t b0 = dims[0] / dmin;
-    size_t b1 = dims[1] / dmin;
-    size_t b2 = dims[2] / dmin;
-    sample_dims[0] = b0 * 2 * sampling_block;
-    sample_dims[1] = b1 * 2 * sampling_block;
-    sample_dims[2] = b2 * 2 * sampling_block;
-    size_t di, dj, dk;
-    sample_num = sample_dims[0] * sample_dims[1] * sample_dims[2];
-    std::vector<T> sampling_data(sample_num, 0);
-
-    for (size_t bi = 0; bi < b0; bi++) {
-        for (size_t bj = 0; bj < b1; bj++) {
-            for (size_t bk = 0; bk < b2; bk++) {
-                for (size_t i = 0; i < 2 * sampling_block; i++) {
-                    for (size_t j = 0; j < 2 * sampling_block; j++) {
-                        for (size_t k = 0; k < 2 * sampling_block; k++) {
-                            di = i < sampling_block ? i + sampling_block : dmin - 3 * sampling_block + i;
-                            dj = j < sampling_block ? j + sampling_block : dmin - 3 * sampling_block + j;
-                            dk = k < sampling_block ? k + sampling_block : dmin - 3 * sampling_block + k;
-                            auto d = data[(bi * dmin + di) * dims[1] * dims[2] + (bj * dmin + dj) * dims[2] +
-                                          bk * dmin + dk];
-                            sampling_data[(bi * 2 * sampling_block + i) * sample_dims[1] * sample_dims[2] +
-                                          (bj * 2 * sampling_block + j) * sample_dims[2] + bk * 2 * sampling_block +
-                                          k] = d;
-                        }
-                    }
-                }
-            }
+    size_t sb = sampling_block;
+    sample_num = 1;
+    for (uint d = 0; d < N; d++) {
+        sample_dims[d] = dims[d] / dmin * 2 * sb;
+        sample_num *= sample_dims[d];
+    }
+
+    // offset in data of each sampled index along the outer dimensions
+    std::array<std::vector<size_t>, N> offsets;
+    size_t stride = dims[N - 1];
+    for (int d = static_cast<int>(N) - 2; d >= 0; d--) {
+        offsets[d].resize(sample_dims[d]);
+        for (size_t s = 0; s < sample_dims[d]; s++) {
+            size_t i = s % (2 * sb);
+            size_t di = i < sb ? i + sb : dmin - 3 * sb + i;
+            offsets[d][s] = (s / (2 * sb) * dmin + di) * stride;
         }
-    }
-    //        auto sampling_time = timer.stop();
-    //        printf("Generate sampling data, block = %lu percent = %.3f%% Time = %.3f \n", sampling_block, sample_num *
-    //        100.0 / num,
-    //               sampling_time);
-    return sampling_data;
-}
-
-template <class T, uint N>
-inline typename std::enable_if<N == 2, std::vector<T>>::type sampling(T *data, std::vector<size_t> dims,
-                                                                      size_t &sample_num,
-                                                                      std::vector<size_t> &sample_dims,
-                                                                      size_t &sampling_block) {
-    assert(dims.size() == N);
-    assert(sample_dims.size() == N);
-    Timer timer(true);
-    size_t num = std::accumulate(dims.begin(), dims.end(), static_cast<size_t>(1), std::multiplies<size_t>());
-
-    size_t dmin = *std::min_element(dims.begin(), dims.end());
-    sampling_block = dmin;
-    while (cal_sampling_ratio<N>(sampling_block, num, dmin, dims) > 0.035) {
-        sampling_block--;
-    }
-    if (sampling_block * 2 > dmin) {
-        sampling_block = dmin / 2;
-    }
-    if (sampling_block < 9) {
-        sample_dims = dims;
-        sample_num = num;
-        return std::vector<T>();
-    }
-    size_t b0 = dims[0] / dmin;
-    size_t b1 = dims[1] / dmin;
-    sample_dims[0] = b0 * 2 * sampling_block;
-    sample_dims[1] = b1 * 2 * sampling_block;
-    size_t di, dj;
-    sample_num = sample_dims[0] * sample_dims[1];
-    std::vector<T> sampling_data(sample_num, 0);
-
-    for (size_t bi = 0; bi < b0; bi++) {
-        for (size_t bj = 0; bj < b1; bj++) {
-            for (size_t i = 0; i < 2 * sampling_block; i++) {
-                for (size_t j = 0; j < 2 * sampling_block; j++) {
-                    di = i < sampling_block ? i + sampling_block : dmin - 3 * sampling_block + i;
-                    dj = j < sampling_block ? j + sampling_block : dmin - 3 * sampling_block + j;
-                    auto d = data[(bi * dmin + di) * dims[1] + bj * dmin + dj];
-                    sampling_data[(bi * 2 * sampling_block + i) * sample_dims[1] + bj * 2 * sampling_block + j] = d;
-                }
-            }
+        stride *= dims[d];
+    }
+
+    std::vector<T> sampling_data;
+    sampling_data.reserve(sample_num);
+    std::array<size_t, N> idx{};
+    size_t rows = sample_num / sample_dims[N - 1];
+    size_t blocks = dims[N - 1] / dmin;
+    for (size_t r = 0; r < rows; r++) {
+        size_t offset = 0;
+        for (uint d = 0; d + 1 < N; d++) {
+            offset += offsets[d][idx[d]];
+        }
+        for (size_t b = 0; b < blocks; b++) {
+            const T *block = data + offset + b * dmin;
+            sampling_data.insert(sampling_data.end(), block + sb, block + 2 * sb);
+            sampling_data.insert(sampling_data.end(), block + dmin - 2 * sb, block + dmin - sb);
+        }
+        // next row of the sample
+        for (int d = static_cast<int>(N) - 2; d >= 0 && ++idx[d] == sample_dims[d]; d--) {
+            idx[d] = 0;
         }
     }
-    //        auto sampling_time = timer.stop();
-    //        printf("Generate sampling data, block = %lu percent = %.3f%% Time = %.3f \n", sampling_block, sample_num *
-    //        100.0 / num,
-    //               sampling_time);
     return sampling_data;
 }
 
+/**
+ * Sample the data as one contiguous box at its center.
+ * Unlike sampling(), the box keeps the grid spacing and continuity of the data, so its compression ratio follows that
+ * of the whole data closely. Thin dimensions are taken whole.
+ * @param fraction approximate size of the sample relative to the data
+ * @return the sample with shape sample_dims, or a copy of the data if the sample would be too small to be meaningful
+ */
 template <class T, uint N>
-inline typename std::enable_if<N == 1, std::vector<T>>::type sampling(T *data, std::vector<size_t> dims,
-                                                                      size_t &sample_num,
-                                                                      std::vector<size_t> &sample_dims,
-                                                                      size_t &sampling_block) {
+std::vector<T> sampling_box(const T *data, const std::vector<size_t> &dims, std::vector<size_t> &sample_dims,
+                            double fraction = 0.125) {
     assert(dims.size() == N);
-    assert(sample_dims.size() == N);
-    Timer timer(true);
     size_t num = std::accumulate(dims.begin(), dims.end(), static_cast<size_t>(1), std::multiplies<size_t>());
-
-    size_t dmin = *std::min_element(dims.begin(), dims.end());
-    sampling_block = dmin;
-    while (cal_sampling_ratio<N>(sampling_block, num, dmin, dims) > 0.035) {
-        sampling_block--;
-    }
-    if (sampling_block * 2 > dmin) {
-        sampling_block = dmin / 2;
+    double scale = std::pow(fraction, 1.0 / N);
+    std::vector<size_t> origin(N), extent(N);
+    size_t boxNum = 1;
+    for (uint d = 0; d < N; d++) {
+        extent[d] = static_cast<size_t>(dims[d] * scale);
+        if (extent[d] < 16) {
+            extent[d] = dims[d];
+        }
+        origin[d] = (dims[d] - extent[d]) / 2;
+        boxNum *= extent[d];
     }
-    if (sampling_block < 9) {
+    if (boxNum < 65536 || boxNum > num / 2) {
         sample_dims = dims;
-        sample_num = num;
-        return std::vector<T>();
+        return std::vector<T>(data, data + num);
     }
-    size_t b0 = dims[0] / dmin;
-    sample_dims[0] = b0 * 2 * sampling_block;
-    size_t di;
-    sample_num = sample_dims[0];
-    std::vector<T> sampling_data(sample_num, 0);
-
-    for (size_t bi = 0; bi < b0; bi++) {
-        for (size_t i = 0; i < 2 * sampling_block; i++) {
-            di = i < sampling_block ? i + sampling_block : dmin - 3 * sampling_block + i;
-            auto d = data[bi * dmin + di];
-            sampling_data[bi * 2 * sampling_block + i] = d;
-        }
-    }
-    //        auto sampling_time = timer.stop();
-    //        printf("Generate sampling data, block = %lu percent = %.3f%% Time = %.3f \n", sampling_block, sample_num *
-    //        100.0 / num,
-    //               sampling_time);
-    return sampling_data;
+    sample_dims = extent;
+    std::vector<T> sample(boxNum);
+    copy_box(const_cast<T *>(data), dims, sample.data(), origin, extent, true);
+    return sample;
 }
 }  // namespace SZ3
 
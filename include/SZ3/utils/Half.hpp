@@ -0,0 +1,146 @@
+#ifndef SZ3_HALF_HPP
+#define SZ3_HALF_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "SZ3/utils/Config.hpp"
+
+namespace SZ3 {
+/**
+ * Half precision values (IEEE 754 binary16, and bfloat16, the upper half of a float), stored as their 16 bits.
+ * They convert to and from float implicitly, with rounding to nearest even, so arithmetic on them is done in float.
+ * The pipelines predict and quantize them in float (see SZ_compress_half), the compressed data and the decompressed
+ * values keep the 16-bit width.
+ */
+struct float16 {
+    static constexpr uint8_t data_type = SZ_FLOAT16;
+    static constexpr float max = 65504.0f;
+
+    uint16_t bits;
+
+    float16() = default;
+
+    float16(float v) : bits(from_float(v)) {}
+
+    operator float() const { return to_float(bits); }
+
+    static uint16_t from_float(float v) {
+        uint32_t f = float_bits(v);
+        uint32_t sign = (f >> 16) & 0x8000;
+        f &= 0x7FFFFFFF;
+        if (f >= 0x47800000) {
+            // beyond the range (inf) or nan
+            return static_cast<uint16_t>(sign | (f > 0x7F800000 ? 0x7E00 : 0x7C00));
+        }
+        if (f < 0x38800000) {
+            // subnormal: the addition of 0.5 rounds the value to a multiple of 2^-24 in the low bits
+            float r = bits_float(f) + 0.5f;
+            return static_cast<uint16_t>(sign | (float_bits(r) - 0x3F000000));
+        }
+        // rebias the exponent, round the 13 dropped bits to nearest even (into the exponent, up to inf, if needed)
+        f += 0xC8000FFF + ((f >> 13) & 1);
+        return static_cast<uint16_t>(sign | (f >> 13));
+    }
+
+    static float to_float(uint16_t h) {
+        uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+        uint32_t em = h & 0x7FFF;
+        if (em >= 0x7C00) {
+            return bits_float(sign | 0x7F800000 | ((em & 0x3FF) << 13));
+        }
+        if (em >= 0x400) {
+            return bits_float(sign | ((em << 13) + 0x38000000));
+        }
+        return bits_float(sign | float_bits(static_cast<float>(em) * 5.9604644775390625e-8f));
+    }
+
+    // distance between consecutive values of magnitude up to m
+    static float spacing(float m) {
+        int e;
+        std::frexp(m, &e);
+        return std::ldexp(1.0f, std::max(e, -13) - 11);
+    }
+
+   private:
+    static uint32_t float_bits(float v) {
+        uint32_t f;
+        memcpy(&f, &v, sizeof(f));
+        return f;
+    }
+
+    static float bits_float(uint32_t f) {
+        float v;
+        memcpy(&v, &f, sizeof(v));
+        return v;
+    }
+};
+
+struct bfloat16 {
+    static constexpr uint8_t data_type = SZ_BFLOAT16;
+    static constexpr float max = 3.38953139e38f;
+
+    uint16_t bits;
+
+    bfloat16() = default;
+
+    bfloat16(float v) : bits(from_float(v)) {}
+
+    operator float() const { return to_float(bits); }
+
+    static uint16_t from_float(float v) {
+        uint32_t f;
+        memcpy(&f, &v, sizeof(f));
+        if ((f & 0x7FFFFFFF) > 0x7F800000) {
+            return static_cast<uint16_t>((f >> 16) | 0x40);
+        }
+        return static_cast<uint16_t>((f + 0x7FFF + ((f >> 16) & 1)) >> 16);
+    }
+
+    static float to_float(uint16_t h) {
+        uint32_t f = static_cast<uint32_t>(h) << 16;
+        float v;
+        memcpy(&v, &f, sizeof(v));
+        return v;
+    }
+
+    // distance between consecutive values of magnitude up to m
+    static float spacing(float m) {
+        int e;
+        std::frexp(m, &e);
+        return std::ldexp(1.0f, std::max(e, -125) - 8);
+    }
+};
+
+static_assert(sizeof(float16) == 2 && sizeof(bfloat16) == 2, "half precision values must be 16 bits");
+
+template <class T>
+struct is_half : std::false_type {};
+
+template <>
+struct is_half<float16> : std::true_type {};
+
+template <>
+struct is_half<bfloat16> : std::true_type {};
+
+/**
+ * type of the computations on values of T: float for half precision, T otherwise
+ */
+template <class T>
+using compute_type = typename std::conditional<is_half<T>::value, float, T>::type;
+
+/**
+ * values computed in float back to T; finite values beyond the range of T are clamped to it
+ */
+template <class T>
+void half_from_float(const float *values, size_t num, T *out) {
+    for (size_t i = 0; i < num; i++) {
+        out[i] = T(std::min(std::max(values[i], -T::max), T::max));
+    }
+}
+}  // namespace SZ3
+
+#endif
@@ -5,35 +5,77 @@
 #ifndef SZ_INTERPOLATORS_HPP
 #define SZ_INTERPOLATORS_HPP
 
+#include <cstdint>
+#include <type_traits>
+
 namespace SZ3 {
+/**
+ * Integer data is interpolated with integer arithmetic: the numerator is summed on 64 bits (wrapping, so that it is
+ * exact for values of up to 32 bits and never overflows), then divided with truncation and converted to T, as the
+ * expressions on T (promoted to int) do for 8- and 16-bit data.
+ */
+template <class T>
+inline uint64_t interp_int(T a) {
+    return static_cast<uint64_t>(a);
+}
+
+template <class T>
+inline T interp_int_div(uint64_t numerator, int64_t denominator) {
+    return static_cast<T>(static_cast<int64_t>(numerator) / denominator);
+}
+
 template <class T>
 inline T interp_linear(T a, T b) {
-    return (a + b) / 2;
+    if constexpr (std::is_integral<T>::value) {
+        return interp_int_div<T>(interp_int(a) + interp_int(b), 2);
+    } else {
+        return (a + b) / 2;
+    }
 }
 
 template <class T>
 inline T interp_linear1(T a, T b) {
-    return -0.5 * a + 1.5 * b;
+    if constexpr (std::is_integral<T>::value) {
+        return interp_int_div<T>(3 * interp_int(b) - interp_int(a), 2);
+    } else {
+        return -0.5 * a + 1.5 * b;
+    }
 }
 
 template <class T>
 inline T interp_quad_1(T a, T b, T c) {
-    return (3 * a + 6 * b - c) / 8;
+    if constexpr (std::is_integral<T>::value) {
+        return interp_int_div<T>(3 * interp_int(a) + 6 * interp_int(b) - interp_int(c), 8);
+    } else {
+        return (3 * a + 6 * b - c) / 8;
+    }
 }
 
 template <class T>
 inline T interp_quad_2(T a, T b, T c) {
-    return (-a + 6 * b + 3 * c) / 8;
+    if constexpr (std::is_integral<T>::value) {
+        return interp_int_div<T>(6 * interp_int(b) + 3 * interp_int(c) - interp_int(a), 8);
+    } else {
+        return (-a + 6 * b + 3 * c) / 8;
+    }
 }
 
 template <class T>
 inline T interp_quad_3(T a, T b, T c) {
-    return (3 * a - 10 * b + 15 * c) / 8;
+    if constexpr (std::is_integral<T>::value) {
+        return interp_int_div<T>(3 * interp_int(a) - 10 * interp_int(b) + 15 * interp_int(c), 8);
+    } else {
+        return (3 * a - 10 * b + 15 * c) / 8;
+    }
 }
 
 template <class T>
 inline T interp_cubic(T a, T b, T c, T d) {
-    return (-a + 9 * b + 9 * c - d) / 16;
+    if constexpr (std::is_integral<T>::value) {
+        return interp_int_div<T>(9 * interp_int(b) + 9 * interp_int(c) - interp_int(a) - interp_int(d), 16);
+    } else {
+        return (-a + 9 * b + 9 * c - d) / 16;
+    }
 }
 
 template <class T>
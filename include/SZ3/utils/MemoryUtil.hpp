@@ -6,6 +6,7 @@
 #define SZ_MEMORYOPS_HPP
 
 #include <cassert>
+#include <cstdint>
 #include <cstring>
 #include <string>
 
@@ -58,5 +59,37 @@ void write(T1 const var, uchar *&compressed_data_pos) {
     compressed_data_pos += sizeof(T1);
 }
 
+// write an unsigned integer in groups of 7 bits, low group first, with the high bit set on all but the last byte
+inline void write_varint(uint64_t var, uchar *&compressed_data_pos) {
+    while (var >= 0x80) {
+        *compressed_data_pos++ = static_cast<uchar>(var | 0x80);
+        var >>= 7;
+    }
+    *compressed_data_pos++ = static_cast<uchar>(var);
+}
+
+// read an unsigned integer written by write_varint
+inline uint64_t read_varint(uchar const *&compressed_data_pos) {
+    uint64_t var = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uchar byte = *compressed_data_pos++;
+        var |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    return var;
+}
+
+// number of bytes written by write_varint
+inline size_t varint_size(uint64_t var) {
+    size_t size = 1;
+    while (var >= 0x80) {
+        var >>= 7;
+        size++;
+    }
+    return size;
+}
+
 }  // namespace SZ3
 #endif  // SZ_MEMORYOPS_HPP
@@ -5,18 +5,62 @@
 #ifndef SZ_STATISTIC_HPP
 #define SZ_STATISTIC_HPP
 
+#include <algorithm>
+#include <vector>
+
 #include "Config.hpp"
+#include "Half.hpp"
+#include "SZ3/executor/Executor.hpp"
 
 namespace SZ3 {
-template <class T>
-T data_range(const T *data, size_t num) {
-    T max = data[0];
-    T min = data[0];
+/**
+ * min and max of the data in a single pass, as values of C (see compute_type)
+ */
+template <class T, class C>
+void data_minmax(const T *data, size_t num, C &min, C &max) {
+    C mn = data[0];
+    C mx = data[0];
+#pragma omp simd reduction(min : mn) reduction(max : mx)
     for (size_t i = 1; i < num; i++) {
-        if (max < data[i]) max = data[i];
-        if (min > data[i]) min = data[i];
+        C v = data[i];
+        mn = v < mn ? v : mn;
+        mx = v > mx ? v : mx;
+    }
+    min = mn;
+    max = mx;
+}
+
+/**
+ * max - min of the data; blocks of the data are reduced in parallel if an executor is given
+ */
+template <class T>
+compute_type<T> data_range(const T *data, size_t num, concepts::ExecutorInterface *executor = nullptr) {
+    using C = compute_type<T>;
+    size_t nBlocks = executor ? std::min<size_t>(executor->concurrency() * 4, num >> 16) : 1;
+    if (nBlocks <= 1) {
+        C min, max;
+        data_minmax(data, num, min, max);
+        return max - min;
     }
-    return max - min;
+    std::vector<C> min_b(nBlocks), max_b(nBlocks);
+    executor->parallel_for(nBlocks, [&](size_t b) {
+        size_t begin = b * num / nBlocks, end = (b + 1) * num / nBlocks;
+        data_minmax(data + begin, end - begin, min_b[b], max_b[b]);
+    });
+    return *std::max_element(max_b.begin(), max_b.end()) - *std::min_element(min_b.begin(), min_b.end());
+}
+
+/**
+ * value range of the data, computed once and cached in conf.valueRange.
+ * conf must be a copy owned by the compressor: a range cached in a Config the caller reuses would be taken for the
+ * range of the next data. The range pass runs in parallel on the executor bound to the current thread, if any.
+ */
+template <class T>
+double value_range(Config &conf, const T *data) {
+    if (conf.valueRange < 0) {
+        conf.valueRange = data_range(data, conf.num, concepts::ExecutorInterface::current());
+    }
+    return conf.valueRange;
 }
 
 inline int factorial(int n) { return (n == 0) || (n == 1) ? 1 : n * factorial(n - 1); }
@@ -28,27 +72,31 @@ inline double computeABSErrBoundFromPSNR(double psnr, double threshold, double v
     return value_range * v3;
 }
 
+/**
+ * convert the error bound of conf to an absolute error bound
+ * @param range value range of the data if known, otherwise conf.valueRange or computed (see value_range)
+ */
 template <class T>
 void calAbsErrorBound(Config &conf, const T *data, T range = 0) {
+    if (range > 0) {
+        conf.valueRange = range;
+    }
     if (conf.errorBoundMode != EB_ABS) {
         if (conf.errorBoundMode == EB_REL) {
             conf.errorBoundMode = EB_ABS;
-            conf.absErrorBound = conf.relErrorBound * ((range > 0) ? range : data_range(data, conf.num));
+            conf.absErrorBound = conf.relErrorBound * value_range(conf, data);
         } else if (conf.errorBoundMode == EB_PSNR) {
             conf.errorBoundMode = EB_ABS;
-            conf.absErrorBound = computeABSErrBoundFromPSNR(conf.psnrErrorBound, 0.99,
-                                                            ((range > 0) ? range : data_range(data, conf.num)));
+            conf.absErrorBound = computeABSErrBoundFromPSNR(conf.psnrErrorBound, 0.99, value_range(conf, data));
         } else if (conf.errorBoundMode == EB_L2NORM) {
             conf.errorBoundMode = EB_ABS;
             conf.absErrorBound = sqrt(3.0 / conf.num) * conf.l2normErrorBound;
         } else if (conf.errorBoundMode == EB_ABS_AND_REL) {
             conf.errorBoundMode = EB_ABS;
-            conf.absErrorBound =
-                std::min(conf.absErrorBound, conf.relErrorBound * ((range > 0) ? range : data_range(data, conf.num)));
+            conf.absErrorBound = std::min(conf.absErrorBound, conf.relErrorBound * value_range(conf, data));
         } else if (conf.errorBoundMode == EB_ABS_OR_REL) {
             conf.errorBoundMode = EB_ABS;
-            conf.absErrorBound =
-                std::max(conf.absErrorBound, conf.relErrorBound * ((range > 0) ? range : data_range(data, conf.num)));
+            conf.absErrorBound = std::max(conf.absErrorBound, conf.relErrorBound * value_range(conf, data));
         } else {
             printf("Error, error bound mode not supported\n");
             exit(0);
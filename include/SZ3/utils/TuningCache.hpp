@@ -0,0 +1,116 @@
+#ifndef SZ3_TUNING_CACHE_HPP
+#define SZ3_TUNING_CACHE_HPP
+
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "SZ3/utils/Config.hpp"
+
+namespace SZ3 {
+
+/**
+ * copy the settings chosen by ALGO_INTERP_LORENZO auto-tuning from one config to another
+ */
+inline void apply_tuning(const Config &tuned, Config &conf) {
+    conf.cmprAlgo = tuned.cmprAlgo;
+    conf.interpAlgo = tuned.interpAlgo;
+    conf.interpDirection = tuned.interpDirection;
+    conf.lorenzo = tuned.lorenzo;
+    conf.lorenzo2 = tuned.lorenzo2;
+    conf.regression = tuned.regression;
+    conf.regression2 = tuned.regression2;
+    conf.quantbinCnt = tuned.quantbinCnt;
+    conf.blockSize = tuned.blockSize;
+    conf.pred_dim = tuned.pred_dim;
+}
+
+/**
+ * Cheap statistic of the sampled data used to detect drift: mean absolute difference of consecutive samples,
+ * relative to the error bound.
+ */
+template <class T>
+double tuning_statistic(const std::vector<T> &sample, double eb) {
+    if (sample.size() < 2 || eb <= 0) {
+        return 0;
+    }
+    double sum = 0;
+    for (size_t i = 1; i < sample.size(); i++) {
+        sum += std::fabs(static_cast<double>(sample[i]) - static_cast<double>(sample[i - 1]));
+    }
+    return sum / (sample.size() - 1) / eb;
+}
+
+/**
+ * TuningCache keeps the settings chosen by ALGO_INTERP_LORENZO auto-tuning, so that later compressions of the same
+ * field (e.g., the next timesteps) skip the trial compressions.
+ * Entries are keyed by shape and conf.fieldId. An entry is used only while the error bound and the tuning statistic of
+ * the sampled data stay within the given relative tolerance of the values it was tuned on; otherwise the field is tuned
+ * again and the entry replaced.
+ * While a cache is bound to the current thread (see BindScope in utils/Workspace.hpp), SZ_compress_Interp_lorenzo
+ * uses it. The cache is thread-safe, so it may be bound on several threads at once.
+ */
+class TuningCache {
+   public:
+    explicit TuningCache(double tolerance = 0.1) : tolerance(tolerance) {}
+
+    TuningCache(const TuningCache &) = delete;
+    TuningCache &operator=(const TuningCache &) = delete;
+
+    /**
+     * @return true and the tuned settings in tuned if a valid entry exists for conf
+     */
+    bool find(const Config &conf, double statistic, Config &tuned) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto entry = entries.find(key(conf));
+        if (entry == entries.end() || drifted(entry->second.absErrorBound, conf.absErrorBound) ||
+            drifted(entry->second.statistic, statistic)) {
+            misses++;
+            return false;
+        }
+        hits++;
+        tuned = entry->second.tuned;
+        return true;
+    }
+
+    void insert(const Config &tuned, double statistic) {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries[key(tuned)] = {tuned, tuned.absErrorBound, statistic};
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+    }
+
+    size_t hit_count() const { return hits; }
+
+    size_t miss_count() const { return misses; }
+
+    static TuningCache *&current() {
+        static thread_local TuningCache *cache = nullptr;
+        return cache;
+    }
+
+   private:
+    struct Entry {
+        Config tuned;
+        double absErrorBound;
+        double statistic;
+    };
+
+    static std::pair<std::vector<size_t>, int> key(const Config &conf) { return {conf.dims, conf.fieldId}; }
+
+    bool drifted(double ref, double value) const { return std::fabs(value - ref) > tolerance * std::fabs(ref); }
+
+    double tolerance;
+    std::mutex mutex;
+    std::map<std::pair<std::vector<size_t>, int>, Entry> entries;
+    std::atomic<size_t> hits{0}, misses{0};
+};
+}  // namespace SZ3
+
+#endif  // SZ3_TUNING_CACHE_HPP
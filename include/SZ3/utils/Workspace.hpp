@@ -0,0 +1,99 @@
+#ifndef SZ3_WORKSPACE_HPP
+#define SZ3_WORKSPACE_HPP
+
+#include <array>
+#include <cstdlib>
+#include <vector>
+
+#include "SZ3/def.hpp"
+
+namespace SZ3 {
+
+/**
+ * Scratch slots in a Workspace. Modules that may be active at the same time must use different slots.
+ */
+enum WORKSPACE_SLOT { WS_LOSSLESS_SRC, WS_LOSSLESS_DST, WS_TUNING, WS_SHUFFLE, WS_SLOT_COUNT };
+
+/**
+ * Workspace keeps scratch memory alive across compression calls.
+ * While a workspace is bound to the current thread (see BindScope), ScratchBuffer takes memory from it instead of
+ * allocating a new buffer in each call. Buffers only grow, so same-shaped inputs do not allocate in steady state.
+ */
+class Workspace {
+   public:
+    uchar *get(WORKSPACE_SLOT slot, size_t size) {
+        auto &buffer = buffers[slot];
+        if (buffer.size() < size) {
+            buffer.resize(size);
+        }
+        return buffer.data();
+    }
+
+    static Workspace *&current() {
+        static thread_local Workspace *ws = nullptr;
+        return ws;
+    }
+
+   private:
+    std::array<std::vector<uchar>, WS_SLOT_COUNT> buffers;
+};
+
+/**
+ * Bind a resource (e.g., Workspace) to the current thread for the lifetime of the scope.
+ * The resource must provide a static thread-local current() accessor.
+ */
+template <class Resource>
+class BindScope {
+   public:
+    explicit BindScope(Resource &resource) : prev(Resource::current()) { Resource::current() = &resource; }
+
+    // keeps the current binding if resource is nullptr
+    explicit BindScope(Resource *resource) : prev(Resource::current()) {
+        if (resource != nullptr) {
+            Resource::current() = resource;
+        }
+    }
+
+    ~BindScope() { Resource::current() = prev; }
+
+    BindScope(const BindScope &) = delete;
+    BindScope &operator=(const BindScope &) = delete;
+
+   private:
+    Resource *prev;
+};
+
+/**
+ * A scratch buffer taken from the workspace bound to the current thread, or from the heap if there is none.
+ */
+class ScratchBuffer {
+   public:
+    ScratchBuffer(WORKSPACE_SLOT slot, size_t size) {
+        auto ws = Workspace::current();
+        if (ws != nullptr) {
+            buffer = ws->get(slot, size);
+        } else {
+            buffer = static_cast<uchar *>(malloc(size));
+            owned = true;
+        }
+    }
+
+    ~ScratchBuffer() {
+        if (owned) {
+            free(buffer);
+        }
+    }
+
+    ScratchBuffer(const ScratchBuffer &) = delete;
+    ScratchBuffer &operator=(const ScratchBuffer &) = delete;
+
+    uchar *data() const { return buffer; }
+
+   private:
+    uchar *buffer = nullptr;
+    bool owned = false;
+};
+
+}  // namespace SZ3
+
+#endif  // SZ3_WORKSPACE_HPP
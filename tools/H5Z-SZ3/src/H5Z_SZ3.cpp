@@ -1,5 +1,6 @@
 #include "H5Z_SZ3.hpp"
 
+#include <cstdlib>
 #include <fstream>
 #include <iterator>
 #include <memory>
@@ -96,7 +97,13 @@ static herr_t H5Z_sz3_set_local(hid_t dcpl_id, hid_t type_id, hid_t chunk_space_
     std::vector<size_t> dims(dims_all, dims_all + ndims);
     // update conf with datatype
     conf.dataType = SZ_FLOAT;
-    if (dclass == H5T_FLOAT)
+    if (dclass == H5T_FLOAT && dsize == 2) {
+        // half precision and bfloat16 differ in the size of the mantissa
+        size_t spos, epos, esize, mpos, msize;
+        if (0 > H5Tget_fields(type_id, &spos, &epos, &esize, &mpos, &msize))
+            H5Z_SZ_PUSH_AND_GOTO(H5E_ARGS, H5E_BADTYPE, -1, "Error in calling H5Tget_fields(type_id)....");
+        conf.dataType = msize == 7 ? SZ_BFLOAT16 : SZ_FLOAT16;
+    } else if (dclass == H5T_FLOAT)
         conf.dataType = dsize == 4 ? SZ_FLOAT : SZ_DOUBLE;
     else if (dclass == H5T_INTEGER) {
         H5T_sign_t dsign;
@@ -144,8 +151,30 @@ static herr_t H5Z_sz3_set_local(hid_t dcpl_id, hid_t type_id, hid_t chunk_space_
     return 1;
 }
 
+/**
+ * zstd dictionary for the chunks (see SZ_train_dictionary in SZ3/api/context.hpp), read once from the file named by the
+ * SZ3_ZSTD_DICTIONARY environment variable; nullptr if it is not set. Data written with it can only be read with it.
+ */
+SZ3::ZstdDictionary *H5Z_sz3_dictionary() {
+    static std::unique_ptr<SZ3::ZstdDictionary> dictionary = []() -> std::unique_ptr<SZ3::ZstdDictionary> {
+        const char *path = std::getenv("SZ3_ZSTD_DICTIONARY");
+        if (path == nullptr || *path == 0) {
+            return nullptr;
+        }
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error(std::string("cannot read the zstd dictionary ") + path);
+        }
+        std::vector<SZ3::uchar> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return std::unique_ptr<SZ3::ZstdDictionary>(new SZ3::ZstdDictionary(std::move(content)));
+    }();
+    return dictionary.get();
+}
+
 template <typename T>
 void process_data(SZ3::Config &conf, void **buf, size_t *buf_size, size_t nbytes, bool is_decompress) {
+    // keeps the dictionary bound by the application, if any, when SZ3_ZSTD_DICTIONARY is not set
+    SZ3::BindScope<SZ3::ZstdDictionary> dictionaryScope(H5Z_sz3_dictionary());
     if (is_decompress) {
         T *processedData = static_cast<T *>(malloc(conf.num * sizeof(T)));
         SZ_decompress(conf, static_cast<char *>(*buf), nbytes, processedData);
@@ -153,7 +182,7 @@ void process_data(SZ3::Config &conf, void **buf, size_t *buf_size, size_t nbytes
         *buf = processedData;
         *buf_size = conf.num * sizeof(T);
     } else {
-        size_t cmpCap = sizeof(T) * conf.num;
+        size_t cmpCap = SZ_compress_bound<T>(conf);
         char *cmpData = static_cast<char *>(malloc(cmpCap));
         *buf_size = SZ_compress(conf, static_cast<T *>(*buf), cmpData, cmpCap);
         free(*buf);
@@ -173,6 +202,7 @@ void process_data(SZ3::Config &conf, void **buf, size_t *buf_size, size_t nbytes
 static size_t H5Z_filter_sz3(unsigned int flags, size_t cd_nelmts, const unsigned int cd_values[], size_t nbytes,
                              size_t *buf_size, void **buf) {
     printf("start H5Z_filter_sz3\n");
+    static char const *_funcname_ = "H5Z_filter_sz3";
 
     if (cd_nelmts == 0)  // this is special data such as string, which should not be treated as values.
         return nbytes;
@@ -186,40 +216,52 @@ static size_t H5Z_filter_sz3(unsigned int flags, size_t cd_nelmts, const unsigne
     if (conf.num < 20) return nbytes;
 
     bool is_decompress = flags & H5Z_FLAG_REVERSE;
-    switch (conf.dataType) {
-        case SZ_FLOAT:
-            process_data<float>(conf, buf, buf_size, nbytes, is_decompress);
-            break;
-        case SZ_DOUBLE:
-            process_data<double>(conf, buf, buf_size, nbytes, is_decompress);
-            break;
-        case SZ_INT8:
-            process_data<int8_t>(conf, buf, buf_size, nbytes, is_decompress);
-            break;
-        case SZ_UINT8:
-            process_data<uint8_t>(conf, buf, buf_size, nbytes, is_decompress);
-            break;
-        case SZ_INT16:
-            process_data<int16_t>(conf, buf, buf_size, nbytes, is_decompress);
-            break;
-        case SZ_UINT16:
-            process_data<uint16_t>(conf, buf, buf_size, nbytes, is_decompress);
-            break;
-        case SZ_INT32:
-            process_data<int32_t>(conf, buf, buf_size, nbytes, is_decompress);
-            break;
-        case SZ_UINT32:
-            process_data<uint32_t>(conf, buf, buf_size, nbytes, is_decompress);
-            break;
-        case SZ_INT64:
-            process_data<int64_t>(conf, buf, buf_size, nbytes, is_decompress);
-            break;
-        case SZ_UINT64:
-            process_data<uint64_t>(conf, buf, buf_size, nbytes, is_decompress);
-            break;
-        default:
-            std::cerr << (is_decompress ? "Decompression" : "Compression") << " Error: Unknown Datatype" << std::endl;
-            std::exit(EXIT_FAILURE);
+    try {
+        switch (conf.dataType) {
+            case SZ_FLOAT:
+                process_data<float>(conf, buf, buf_size, nbytes, is_decompress);
+                break;
+            case SZ_DOUBLE:
+                process_data<double>(conf, buf, buf_size, nbytes, is_decompress);
+                break;
+            case SZ_INT8:
+                process_data<int8_t>(conf, buf, buf_size, nbytes, is_decompress);
+                break;
+            case SZ_UINT8:
+                process_data<uint8_t>(conf, buf, buf_size, nbytes, is_decompress);
+                break;
+            case SZ_INT16:
+                process_data<int16_t>(conf, buf, buf_size, nbytes, is_decompress);
+                break;
+            case SZ_UINT16:
+                process_data<uint16_t>(conf, buf, buf_size, nbytes, is_decompress);
+                break;
+            case SZ_INT32:
+                process_data<int32_t>(conf, buf, buf_size, nbytes, is_decompress);
+                break;
+            case SZ_UINT32:
+                process_data<uint32_t>(conf, buf, buf_size, nbytes, is_decompress);
+                break;
+            case SZ_INT64:
+                process_data<int64_t>(conf, buf, buf_size, nbytes, is_decompress);
+                break;
+            case SZ_UINT64:
+                process_data<uint64_t>(conf, buf, buf_size, nbytes, is_decompress);
+                break;
+            case SZ_FLOAT16:
+                process_data<SZ3::float16>(conf, buf, buf_size, nbytes, is_decompress);
+                break;
+            case SZ_BFLOAT16:
+                process_data<SZ3::bfloat16>(conf, buf, buf_size, nbytes, is_decompress);
+                break;
+            default:
+                std::cerr << (is_decompress ? "Decompression" : "Compression") << " Error: Unknown Datatype"
+                          << std::endl;
+                std::exit(EXIT_FAILURE);
+        }
+    } catch (const std::exception &e) {
+        // e.g., data compressed with a zstd dictionary that is not set (SZ3_ZSTD_DICTIONARY)
+        H5Z_SZ_PUSH_AND_GOTO(H5E_PLINE, H5E_CANTFILTER, 0, e.what());
     }
     return *buf_size;
 }
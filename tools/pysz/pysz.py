@@ -42,8 +42,10 @@ class SZ:
             return 0, data.ctypes.data_as(ctypes.POINTER(ctypes.c_float)) if data is not None else None
         elif dtype == np.float64:
             return 1, data.ctypes.data_as(ctypes.POINTER(ctypes.c_double)) if data is not None else None
+        elif dtype == np.float16:
+            return 10, data.ctypes.data_as(ctypes.POINTER(ctypes.c_uint16)) if data is not None else None
         else:
-            print('SZ currently supports float32 and float64\n')
+            print('SZ currently supports float16, float32 and float64\n')
             exit(0)
 
     def verify(self, src_data, dec_data):
@@ -73,21 +75,27 @@ class SZ:
 
         r5, r4, r3, r2, r1 = [0] * (5 - len(original_shape)) + list(original_shape)
         ori_type, ori_null = self.__sz_datatype(original_dtype)
-        self.sz.SZ_decompress.restype = ctypes.POINTER(
-            ctypes.c_float if original_dtype == np.float32 else ctypes.c_double)
+        if original_dtype == np.float16:
+            # half precision values are passed as their bits
+            self.sz.SZ_decompress.restype = ctypes.POINTER(ctypes.c_uint16)
+        else:
+            self.sz.SZ_decompress.restype = ctypes.POINTER(
+                ctypes.c_float if original_dtype == np.float32 else ctypes.c_double)
         data_dec_c = self.sz.SZ_decompress(ori_type,
                                            data_cmpr.ctypes.data_as(ctypes.POINTER(ctypes.c_ubyte)),
                                            data_cmpr.size,
                                            r5, r4, r3, r2, r1)
 
-        data_dec = np.array(data_dec_c[:np.prod(original_shape)], dtype=original_dtype).reshape(original_shape)
+        data_dec = np.array(data_dec_c[:np.prod(original_shape)],
+                            dtype=np.uint16 if original_dtype == np.float16 else original_dtype)
+        data_dec = data_dec.view(original_dtype).reshape(original_shape)
         self.libc.free(data_dec_c)
         return data_dec
 
     def compress(self, data, eb_mode, eb_abs, eb_rel, eb_pwr):
         """
         Compress data with SZ
-        :param data: original data, numpy array format, dtype is FP32 or FP64
+        :param data: original data, numpy array format, dtype is FP16, FP32 or FP64
         :param eb_mode:# error bound mode, integer (0: ABS, 1:REL, 2:ABS_AND_REL, 3:ABS_OR_REL, 4:PSNR, 5:NORM, 10:PW_REL)
         :param eb_abs: optional, abs error bound, double
         :param eb_rel: optional, rel error bound, double
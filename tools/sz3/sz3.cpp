@@ -46,6 +46,8 @@ inline void usage() {
     printf("		NORM (norm2 error : sqrt(sum(xi-xi')^2)\n");
     printf("		ABS_AND_REL (using min{ABS, REL})\n");
     printf("		ABS_OR_REL (using max{ABS, REL})\n");
+    printf("		RATIO (target compression ratio, the error bound is searched with trial compressions)\n");
+    printf("		BITRATE (target bits per value, the error bound is searched with trial compressions)\n");
     printf(
         "	error bound can be set directly after the error control mode, or separately with the following "
         "options:\n");
@@ -63,6 +65,7 @@ inline void usage() {
     printf("	sz -f -i test.dat    -z test.dat.sz     -3 8 8 128 -M ABS 1e-3 \n");
     printf("	sz -f -z test.dat.sz -o test.dat.sz.out -3 8 8 128 -M REL 1e-3 -a \n");
     printf("	sz -f -i test.dat    -o test.dat.sz.out -3 8 8 128 -M ABS_AND_REL -A 1 -R 1e-3 -a \n");
+    printf("	sz -f -i test.dat    -z test.dat.sz     -3 8 8 128 -M RATIO 20 \n");
     printf("	sz -f -i test.dat    -o test.dat.sz.out -3 8 8 128 -c sz.config \n");
     printf("	sz -f -i test.dat    -o test.dat.sz.out -3 8 8 128 -c sz.config -M ABS 1e-3 -a\n");
     exit(0);
@@ -388,7 +391,8 @@ int main(int argc, char *argv[]) {
     } else {
         conf = SZ3::Config(r4, r3, r2, r1);
     }
-    if (compression && conPath != nullptr) {
+    if (conPath != nullptr) {
+        // settings not stored in the compressed data (e.g., OpenMPThreads) also apply to decompression
         conf.loadcfg(conPath);
     }
 
@@ -432,6 +436,16 @@ int main(int argc, char *argv[]) {
             conf.errorBoundMode = SZ3::EB_ABS_AND_REL;
         } else if (strcmp(errBoundMode, SZ3::EB_STR[SZ3::EB_ABS_OR_REL]) == 0) {
             conf.errorBoundMode = SZ3::EB_ABS_OR_REL;
+        } else if (strcmp(errBoundMode, SZ3::EB_STR[SZ3::EB_RATIO]) == 0) {
+            conf.errorBoundMode = SZ3::EB_RATIO;
+            if (errBound != nullptr) {
+                conf.targetRatio = atof(errBound);
+            }
+        } else if (strcmp(errBoundMode, SZ3::EB_STR[SZ3::EB_BITRATE]) == 0) {
+            conf.errorBoundMode = SZ3::EB_BITRATE;
+            if (errBound != nullptr) {
+                conf.targetBitrate = atof(errBound);
+            }
         } else {
             printf("Error: wrong error bound mode setting by using the option '-M'\n");
             usage();
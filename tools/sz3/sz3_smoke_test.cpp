@@ -2,6 +2,10 @@
 // Created by Kai Zhao on 11/10/22.
 //
 
+#include <SZ3/api/async.hpp>
+#include <SZ3/api/batch.hpp>
+#include <SZ3/api/context.hpp>
+#include <SZ3/api/stream.hpp>
 #include <SZ3/api/sz.hpp>
 
 #include "SZ3/compressor/specialized/SZTruncateCompressor.hpp"
@@ -10,6 +14,320 @@
 #include "SZ3/encoder/RunlengthEncoder.hpp"
 #include "SZ3/lossless/Lossless_bypass.hpp"
 
+template <class T, class U>
+double max_error(const T *a, const U *b, size_t num) {
+    double max_err = 0.0;
+    for (size_t i = 0; i < num; i++) {
+        max_err = std::max(max_err, fabs(static_cast<double>(a[i]) - static_cast<double>(b[i])));
+    }
+    return max_err;
+}
+
+bool report(const char *name, bool passed) {
+    printf("%s %s\n", name, passed ? "passed" : "failed");
+    return passed;
+}
+
+// the compact header round trip keeps the dims and every setting that differs from the defaults
+bool test_header() {
+    SZ3::Config conf(30, 40, 50);
+    conf.cmprAlgo = SZ3::ALGO_LORENZO_REG;
+    conf.errorBoundMode = SZ3::EB_REL;
+    conf.relErrorBound = 1E-4;
+    conf.quantbinCnt = 1024;
+    conf.blockSize = 8;
+    conf.openmp = true;
+
+    std::vector<SZ3::uchar> header(SZ3::Config::max_saved_size(conf.dims));
+    auto pos = header.data();
+    size_t len = conf.save(pos);
+
+    SZ3::Config loaded;
+    const SZ3::uchar *loadPos = header.data();
+    loaded.load(loadPos);
+    return len == conf.saved_size() && len == static_cast<size_t>(loadPos - header.data()) &&
+           SZ3::Config::header_size(header.data(), loadPos) == len && loaded.dims == conf.dims &&
+           loaded.cmprAlgo == conf.cmprAlgo && loaded.errorBoundMode == conf.errorBoundMode &&
+           loaded.relErrorBound == conf.relErrorBound && loaded.quantbinCnt == conf.quantbinCnt &&
+           loaded.blockSize == conf.blockSize && loaded.openmp == conf.openmp && loaded.lossless == conf.lossless;
+}
+
+// fixed-layout header written by SZ3 3.2.0, padded to Config::size_est()
+bool test_legacy_header() {
+    std::vector<size_t> dims({30, 40});
+    std::vector<SZ3::uchar> header(SZ3::Config::size_est(), 0);
+    auto pos = header.data();
+    SZ3::write(static_cast<uint32_t>(SZ3_MAGIC_NUMBER), pos);
+    SZ3::write(versionInt("3.2.0"), pos);
+    SZ3::write(static_cast<char>(dims.size()), pos);
+    auto bitWidth = SZ3::vector_bit_width(dims);
+    SZ3::write(bitWidth, pos);
+    SZ3::vector2bytes(dims, bitWidth, pos);
+    SZ3::write(dims[0] * dims[1], pos);
+    SZ3::write(static_cast<uint8_t>(SZ3::ALGO_NOPRED), pos);
+    SZ3::write(static_cast<uint8_t>(SZ3::EB_ABS), pos);
+    SZ3::write(1E-3, pos);
+    SZ3::write(static_cast<uint8_t>(0), pos);         // lorenzo, lorenzo2, regression, regression2, openmp
+    SZ3::write(static_cast<uint8_t>(SZ_FLOAT), pos);  // dataType
+    SZ3::write(static_cast<uint8_t>(0), pos);         // lossless
+    SZ3::write(static_cast<uint8_t>(1), pos);         // encoder
+    SZ3::write(static_cast<uint8_t>(0), pos);         // interpAlgo
+    SZ3::write(static_cast<uint8_t>(0), pos);         // interpDirection
+    SZ3::write(65536, pos);                           // quantbinCnt
+    SZ3::write(6, pos);                               // blockSize
+    SZ3::write(0, pos);                               // stride
+    SZ3::write(static_cast<uint8_t>(0), pos);         // pred_dim
+
+    SZ3::Config conf;
+    const SZ3::uchar *loadPos = header.data();
+    conf.load(loadPos);
+    // payloads of that version were always wrapped by zstd, whatever the lossless setting
+    return conf.dims == dims && conf.num == dims[0] * dims[1] && conf.cmprAlgo == SZ3::ALGO_NOPRED &&
+           conf.absErrorBound == 1E-3 && conf.lossless == 1 && conf.blockSize == 6 &&
+           SZ3::Config::header_size(header.data(), loadPos) == SZ3::Config::size_est();
+}
+
+bool test_integer() {
+    SZ3::Config conf(200, 300);
+    conf.errorBoundMode = SZ3::EB_ABS;
+    conf.absErrorBound = 2;
+    std::vector<int32_t> data(conf.num);
+    for (size_t i = 0; i < conf.num; i++) {
+        data[i] = static_cast<int32_t>(1000 * sin(i * 0.001) + (i * 7919) % 13);
+    }
+    size_t cmpSize;
+    char *cmpData = SZ_compress(conf, data.data(), cmpSize);
+    std::vector<int32_t> dec(conf.num);
+    auto decPos = dec.data();
+    SZ3::Config decConf;
+    SZ_decompress(decConf, cmpData, cmpSize, decPos);
+    delete[] cmpData;
+    return max_error(dec.data(), data.data(), conf.num) <= conf.absErrorBound;
+}
+
+bool test_half() {
+    SZ3::Config conf(64, 64, 64);
+    conf.errorBoundMode = SZ3::EB_ABS;
+    conf.absErrorBound = 1E-2;
+    std::vector<SZ3::float16> data(conf.num);
+    for (size_t i = 0; i < conf.num; i++) {
+        data[i] = SZ3::float16(static_cast<float>(10 * sin(i * 0.01)));
+    }
+    size_t cmpSize;
+    char *cmpData = SZ_compress(conf, data.data(), cmpSize);
+    std::vector<SZ3::float16> dec(conf.num);
+    auto decPos = dec.data();
+    SZ3::Config decConf;
+    SZ_decompress(decConf, cmpData, cmpSize, decPos);
+    delete[] cmpData;
+    std::vector<float> dataFloat(data.begin(), data.end()), decFloat(dec.begin(), dec.end());
+    return decConf.dataType == SZ_FLOAT16 &&
+           max_error(decFloat.data(), dataFloat.data(), conf.num) <= conf.absErrorBound;
+}
+
+// double data decompressed straight into a float array
+bool test_convert() {
+    SZ3::Config conf(100, 500);
+    conf.errorBoundMode = SZ3::EB_ABS;
+    conf.absErrorBound = 1E-3;
+    std::vector<double> data(conf.num);
+    for (size_t i = 0; i < conf.num; i++) {
+        data[i] = sin(i * 0.002) + cos(i * 0.0007);
+    }
+    size_t cmpSize;
+    char *cmpData = SZ_compress(conf, data.data(), cmpSize);
+    std::vector<float> dec(conf.num);
+    auto decPos = dec.data();
+    SZ3::Config decConf;
+    SZ_decompress_convert<double>(decConf, cmpData, cmpSize, decPos);
+    delete[] cmpData;
+    // the conversion to float adds its own rounding
+    return max_error(dec.data(), data.data(), conf.num) <= conf.absErrorBound * (1 + 1E-6) + 1E-6;
+}
+
+// one component of an array of (x, y, z) records, compressed and restored in place
+bool test_strided() {
+    size_t nx = 100, ny = 200;
+    std::vector<float> records(nx * ny * 3);
+    for (size_t i = 0; i < records.size(); i++) {
+        records[i] = static_cast<float>(sin(i * 0.0003) * (i % 3 + 1));
+    }
+    std::vector<size_t> strides({ny * 3, 3});
+    SZ3::Config conf(nx, ny);
+    conf.errorBoundMode = SZ3::EB_ABS;
+    conf.absErrorBound = 1E-3;
+    std::vector<char> cmpData(SZ_compress_bound<float>(conf));
+    size_t cmpSize = SZ_compress_strided(conf, records.data() + 1, strides, cmpData.data(), cmpData.size());
+
+    std::vector<float> dec(records.size(), 0);
+    SZ3::Config decConf;
+    SZ_decompress_strided(decConf, cmpData.data(), cmpSize, dec.data() + 1, strides);
+    double max_err = 0.0;
+    bool untouched = true;
+    for (size_t i = 0; i < records.size(); i++) {
+        if (i % 3 == 1) {
+            max_err = std::max(max_err, fabs(static_cast<double>(dec[i]) - records[i]));
+        } else {
+            untouched = untouched && dec[i] == 0;
+        }
+    }
+    return cmpSize > 0 && untouched && max_err <= conf.absErrorBound;
+}
+
+// a Config planned on one field and reused for another one keeps the relative bound of the other one
+bool test_planned_reuse() {
+    SZ3::Config conf(64, 64, 64);
+    conf.errorBoundMode = SZ3::EB_REL;
+    conf.relErrorBound = 1E-3;
+    conf.timeBudget = 10;
+    std::vector<float> planned(conf.num), data(conf.num);
+    for (size_t i = 0; i < conf.num; i++) {
+        planned[i] = static_cast<float>(sin(i * 0.001));
+        data[i] = planned[i] * 0.01f;
+    }
+    SZ_plan_time_budget(conf, planned.data());
+    size_t cmpSize;
+    char *cmpData = SZ_compress(conf, data.data(), cmpSize);
+    std::vector<float> dec(conf.num);
+    auto decPos = dec.data();
+    SZ3::Config decConf;
+    SZ_decompress(decConf, cmpData, cmpSize, decPos);
+    delete[] cmpData;
+    return conf.valueRange < 0 && max_error(dec.data(), data.data(), conf.num) <= decConf.absErrorBound &&
+           decConf.absErrorBound <= 1E-3 * 0.02 * (1 + 1E-3);
+}
+
+// rows pushed in slabs that do not line up with the segments, read back with a source returning short reads
+bool test_stream() {
+    SZ3::Config conf(100, 60, 40);
+    conf.errorBoundMode = SZ3::EB_ABS;
+    conf.absErrorBound = 1E-3;
+    size_t rowSize = conf.num / conf.dims[0];
+    std::vector<float> data(conf.num);
+    for (size_t i = 0; i < conf.num; i++) {
+        data[i] = static_cast<float>(sin(i * 0.0005));
+    }
+
+    std::vector<char> stream;
+    SZ3::StreamCompressor<float> compressor(
+        [&](const char *bytes, size_t len) { stream.insert(stream.end(), bytes, bytes + len); });
+    compressor.begin(conf, 16);
+    for (size_t row = 0; row < conf.dims[0]; row += 7) {
+        compressor.push_slab(data.data() + row * rowSize, std::min<size_t>(7, conf.dims[0] - row));
+    }
+    compressor.finish();
+
+    size_t readPos = 0;
+    SZ3::StreamDecompressor<float> decompressor([&](char *bytes, size_t len) {
+        len = std::min({len, static_cast<size_t>(5), stream.size() - readPos});
+        memcpy(bytes, stream.data() + readPos, len);
+        readPos += len;
+        return len;
+    });
+    auto decConf = decompressor.begin();
+    std::vector<float> dec(conf.num);
+    size_t rows = 0;
+    while (size_t n = decompressor.next_slab(dec.data() + rows * rowSize)) {
+        rows += n;
+    }
+    return decConf.dims == conf.dims && rows == conf.dims[0] &&
+           max_error(dec.data(), data.data(), conf.num) <= conf.absErrorBound;
+}
+
+// compressed in segments on a thread pool while the caller waits on the futures
+bool test_async() {
+    SZ3::Config conf(200, 50, 40);
+    conf.errorBoundMode = SZ3::EB_REL;
+    conf.relErrorBound = 1E-4;
+    std::vector<float> data(conf.num);
+    for (size_t i = 0; i < conf.num; i++) {
+        data[i] = static_cast<float>(cos(i * 0.0003) * 50);
+    }
+
+    SZ3::Executor_threadpool pool(4);
+    std::vector<char> stream;
+    auto compressed = SZ_compress_async(
+        conf, data.data(), [&](const char *bytes, size_t len) { stream.insert(stream.end(), bytes, bytes + len); },
+        &pool);
+    size_t cmpSize = compressed.get();
+
+    size_t readPos = 0;
+    std::vector<float> dec(conf.num);
+    auto decompressed = SZ_decompress_async<float>(
+        [&](char *bytes, size_t len) {
+            len = std::min(len, stream.size() - readPos);
+            memcpy(bytes, stream.data() + readPos, len);
+            readPos += len;
+            return len;
+        },
+        dec.data(), &pool);
+    auto decConf = decompressed.get();
+    return cmpSize == stream.size() && decConf.dims == conf.dims &&
+           max_error(dec.data(), data.data(), conf.num) <= decConf.absErrorBound;
+}
+
+// three fields, two of the same shape sharing the settings tuned on the first of them
+bool test_batch() {
+    SZ3::Config conf(48, 48, 48), small(20, 30);
+    conf.absErrorBound = small.absErrorBound = 1E-3;
+    std::vector<std::vector<float>> data = {std::vector<float>(conf.num), std::vector<float>(conf.num),
+                                            std::vector<float>(small.num)};
+    for (size_t f = 0; f < data.size(); f++) {
+        for (size_t i = 0; i < data[f].size(); i++) {
+            data[f][i] = static_cast<float>(sin(i * 0.001 * (f + 1)) + f);
+        }
+    }
+    std::vector<SZ3::FieldDesc<float>> fields = {
+        {conf, data[0].data()}, {conf, data[1].data()}, {small, data[2].data()}};
+
+    SZ3::Executor_threadpool pool(3);
+    std::vector<std::vector<char>> outputs(fields.size());
+    size_t total = SZ_compress_batch<float>(
+        fields, [&](size_t i, const char *cmpData, size_t cmpSize) { outputs[i].assign(cmpData, cmpData + cmpSize); },
+        &pool, true);
+
+    bool passed = total > 0;
+    for (size_t f = 0; f < fields.size(); f++) {
+        std::vector<float> dec(data[f].size());
+        auto decPos = dec.data();
+        SZ3::Config decConf;
+        SZ_decompress(decConf, outputs[f].data(), outputs[f].size(), decPos);
+        passed = passed && max_error(dec.data(), data[f].data(), dec.size()) <= fields[f].conf.absErrorBound;
+    }
+    return passed;
+}
+
+// small chunks of one field compressed by a Context with a trained dictionary, decompressed with the stored dictionary
+bool test_dictionary() {
+    SZ3::Config conf(8, 16, 16);
+    conf.absErrorBound = 1E-3;
+    size_t nChunks = 64;
+    std::vector<float> data(nChunks * conf.num);
+    for (size_t i = 0; i < data.size(); i++) {
+        size_t x = i % 16, y = i / 16 % 16, z = i / 256;
+        data[i] = static_cast<float>(sin(x * 0.2 + z * 0.05) * cos(y * 0.15) + 0.01 * ((i * 7919) % 17));
+    }
+    std::vector<const float *> samples;
+    for (size_t c = 0; c < nChunks; c++) {
+        samples.push_back(data.data() + c * conf.num);
+    }
+    auto dict = SZ_train_dictionary(conf, samples);
+
+    SZ3::Context<float> context;
+    context.set_dictionary(dict.get());
+    const float *chunk = samples[nChunks / 2];
+    std::vector<char> cmpData(SZ_compress_bound<float>(conf));
+    size_t cmpSize = context.compress(conf, chunk, cmpData.data(), cmpData.size());
+
+    SZ3::ZstdDictionary stored(dict->content());
+    SZ3::BindScope<SZ3::ZstdDictionary> dictionaryScope(stored);
+    std::vector<float> dec(conf.num);
+    auto decPos = dec.data();
+    SZ3::Config decConf;
+    SZ_decompress(decConf, cmpData.data(), cmpSize, decPos);
+    return cmpSize > 0 && max_error(dec.data(), chunk, conf.num) <= conf.absErrorBound;
+}
+
 int main(int argc, char **argv) {
     std::vector<size_t> dims({100, 200, 300});
     SZ3::Config conf({dims[0], dims[1], dims[2]});
@@ -39,14 +357,20 @@ int main(int argc, char **argv) {
     char *cmpData = SZ_compress(conf, input_data.data(), cmpSize);
     auto dec_data_p = dec_data.data();
     SZ_decompress(conf, cmpData, cmpSize, dec_data_p);
+    delete[] cmpData;
 
-    double max_err = 0.0;
-    for (size_t i = 0; i < conf.num; i++) {
-        if (fabs(dec_data[i] - input_data_copy[i]) > max_err) {
-            max_err = fabs(dec_data[i] - input_data_copy[i]);
-        }
-    }
-    printf("Smoke test %s", max_err <= conf.absErrorBound ? "passed" : "failed");
-    //    printf("%lu ", conf.num);
-    return 0;
+    double max_err = max_error(dec_data.data(), input_data_copy.data(), conf.num);
+    bool passed = report("Smoke test", max_err <= conf.absErrorBound);
+    passed = report("Header round trip", test_header()) && passed;
+    passed = report("Legacy header", test_legacy_header()) && passed;
+    passed = report("Integer round trip", test_integer()) && passed;
+    passed = report("Half precision round trip", test_half()) && passed;
+    passed = report("Conversion round trip", test_convert()) && passed;
+    passed = report("Strided round trip", test_strided()) && passed;
+    passed = report("Planned config reuse", test_planned_reuse()) && passed;
+    passed = report("Stream round trip", test_stream()) && passed;
+    passed = report("Async round trip", test_async()) && passed;
+    passed = report("Batch round trip", test_batch()) && passed;
+    passed = report("Dictionary round trip", test_dictionary()) && passed;
+    return passed ? 0 : 1;
 }
@@ -34,6 +34,9 @@
 #define SZ_UINT64 8
 #define SZ_INT64 9
 /** End dataType in SZ2 (defines.h) **/
+/* 16-bit values (uint16_t in C): IEEE 754 half precision, and bfloat16 */
+#define SZ_FLOAT16 10
+#define SZ_BFLOAT16 11
 
 #ifdef __cplusplus
 extern "C" {
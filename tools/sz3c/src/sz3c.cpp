@@ -46,6 +46,12 @@ unsigned char *SZ_compress_args(int dataType, void *data, size_t *outSize,
         cmpr_data = reinterpret_cast<unsigned char *>(SZ_compress<float>(conf, static_cast<float *>(data), *outSize));
     } else if (dataType == SZ_DOUBLE) {
         cmpr_data = reinterpret_cast<unsigned char *>(SZ_compress<double>(conf, static_cast<double *>(data), *outSize));
+    } else if (dataType == SZ_FLOAT16) {
+        cmpr_data = reinterpret_cast<unsigned char *>(
+            SZ_compress<SZ3::float16>(conf, static_cast<SZ3::float16 *>(data), *outSize));
+    } else if (dataType == SZ_BFLOAT16) {
+        cmpr_data = reinterpret_cast<unsigned char *>(
+            SZ_compress<SZ3::bfloat16>(conf, static_cast<SZ3::bfloat16 *>(data), *outSize));
     } else {
         printf("dataType %d not support\n", dataType);
         exit(0);
@@ -84,6 +90,14 @@ void *SZ_decompress(int dataType, unsigned char *bytes, size_t byteLength,
         auto dec_data = static_cast<double *>(malloc(n * sizeof(double)));
         SZ_decompress<double>(conf, reinterpret_cast<char *>(bytes), byteLength, dec_data);
         return dec_data;
+    } else if (dataType == SZ_FLOAT16) {
+        auto dec_data = static_cast<SZ3::float16 *>(malloc(n * sizeof(SZ3::float16)));
+        SZ_decompress<SZ3::float16>(conf, reinterpret_cast<char *>(bytes), byteLength, dec_data);
+        return dec_data;
+    } else if (dataType == SZ_BFLOAT16) {
+        auto dec_data = static_cast<SZ3::bfloat16 *>(malloc(n * sizeof(SZ3::bfloat16)));
+        SZ_decompress<SZ3::bfloat16>(conf, reinterpret_cast<char *>(bytes), byteLength, dec_data);
+        return dec_data;
     } else {
         printf("dataType %d not support\n", dataType);
         exit(0);